@@ -4,45 +4,340 @@
 #include <ctime>
 #include <cstring>
 #include <cstdio>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include "geometry.h"
+#include "jobs.h"
+#include "text.h"
+#include "random.h"
+#include "particles.h"
+#include "population.h"
+#include "epidemic.h"
+#include "heatmap.h"
+#include "profiler.h"
+#include "redraw.h"
 
 // Structure to represent a mosquito
 struct Mosquito {
     float x, y;       // Position
-    float dx, dy;     // Direction of movement
+    float dx, dy;     // Velocity (units per second)
     float size;       // Size of the mosquito
     bool alive;       // Whether the mosquito is alive
     float deathTimer; // Timer for death animation
+    float age;        // Days since emerging
+    float lifespan;   // Days it lives unless sprayed
+    bool infectious;  // Carries dengue and passes it on when it bites
 };
 
-const int NUM_MOSQUITOES = 35; // More mosquitoes
-Mosquito mosquitoes[NUM_MOSQUITOES];
+// Segment counts for the circles drawn every frame
+const int ROUND_SEGMENTS = 360; // Pond, water bowl and mosquito heads
+const int CLOUD_SEGMENTS = 36;
+
+const int NUM_MOSQUITOES = 35; // More mosquitoes (default swarm size)
+const float MOSQUITO_SIZE = 0.05f; // Body length of every mosquito
+const int SWARM_CHUNK_SIZE = 1024; // Mosquitoes per job in a simulation step
+
+// Swarm state is double buffered: a step reads the front buffer and writes
+// the back one, then they swap. Rendering blends back (previous) into front.
+// Steps still run on the GLUT thread between frames, not alongside drawing:
+// a step also changes the alive and dying lists, the sprays, the brood
+// sites and the household grid, and the frame reads all of them.
+std::vector<Mosquito> swarmStates[2];
+int frontState = 0;
+int swarmSize = NUM_MOSQUITOES;      // Mosquito slots in the pool
 int aliveMosquitoes = NUM_MOSQUITOES; // Track alive mosquitoes
 
-// Variables for pond, water bowl, and spray
+// Swarm slots are split into alive, dying and free lists of slot indices.
+// Updates and drawing walk only the alive and dying lists; slots whose
+// death animation has finished go to the free list for breeding to reuse.
+std::vector<int> aliveList;
+std::vector<int> dyingList;
+std::vector<int> freeList;
+
+// Flocking: each mosquito steers by its neighbours, found through a grid of
+// alive positions rebuilt at the start of every step
+const float NEIGHBOUR_RADIUS = 0.1f;    // How far a mosquito sees its neighbours
+const float SEPARATION_RADIUS = 0.04f;  // Closer than this, neighbours push apart
+const int MAX_NEIGHBOURS = 8;           // Neighbours considered per mosquito
+const float SEPARATION_WEIGHT = 0.002f;
+const float COHESION_WEIGHT = 0.3f;
+const float ALIGNMENT_WEIGHT = 0.5f;
+const float WATER_WEIGHT = 0.02f;       // Pull towards the nearest water
+const float WATER_COMFORT_RADIUS = 0.4f; // No pull once this close to water
+const float SPRAY_SENSE_RADIUS = 0.15f; // How far away a droplet is noticed
+const float SPRAY_AVOID_WEIGHT = 0.5f;
+const float MIN_SPEED = 0.03f;
+const float MAX_SPEED = 0.15f;
+PointGrid swarmGrid;
+std::vector<float> swarmPackedX, swarmPackedY; // Alive positions fed to the grid
+std::vector<float> swarmSortedDx, swarmSortedDy; // Alive velocities in grid cell order
+
+// Life cycle: adults lay eggs in the nearest wet breeding site, eggs hatch
+// into larvae and larvae emerge as adults into free swarm slots. Eggs and
+// larvae live in the brood store; adults are the swarm itself.
+enum Site { SITE_POND, SITE_BOWL, NUM_SITES };
+BreedingSite sites[NUM_SITES];
+BroodStore brood;
+Random broodRandom;
+bool breedingEnabled = true;
+const float ADULT_LIFESPAN_MIN = 14.0f; // Days
+const float ADULT_LIFESPAN_MAX = 30.0f;
+const float EGGS_PER_ADULT_DAY = 5.0f;  // Averaged over males and females
+const float BREED_SPREAD = 0.05f;       // How far from a site a new mosquito appears
+float eggCarry[NUM_SITES];              // Fractional eggs owed to each site
+
+// Biological clock: life-cycle days advanced per simulated second.
+// Fast-forward speeds up aging and breeding but not flight.
+float daysPerSecond = 0.05f;            // A day every 20 seconds
+const float FAST_FORWARD_FACTOR = 100.0f;
+bool fastForward = false;
+double simDay = 0.0;                    // Days since the last reset
+uint64_t simTick = 0;                   // Steps since the last reset
+
+// Dengue in the town: a grid of households over the scene, infected by
+// bites from infectious mosquitoes, which in turn pick the virus up from
+// infectious households
+EpidemicGrid epidemic;
+int householdColumns = 128;
+int householdRows = 96;
+float infectiousFraction = 0.1f;        // Share of the starting swarm carrying the virus
+Random epidemicRandom;
+
+// Infection heatmap drawn over the scene; resampled only after a step
+const int INFECTION_MAP_SIZE = 256;
+const float INFECTION_MAP_SCALE = 4.0f; // 25% of a household infectious shows at full colour
+Heatmap infectionMap;
+bool infectionMapVisible = false;
+bool infectionMapDirty = true;
+
+// Mosquito level of detail, picked once per batch from how many pixels a
+// body covers: every detail when large, a flat silhouette of 8 vertices
+// (two wing triangles and a body line) at the usual size, and a single
+// point when tiny. Batches below full detail go out as vertex arrays.
+enum MosquitoLod {
+    LOD_FULL,       // Head, wings, body and proboscis
+    LOD_SILHOUETTE, // Wings and body
+    LOD_POINT       // One point
+};
+const float LOD_FULL_PIXELS = 40.0f;      // Body length on screen for full detail
+const float LOD_SILHOUETTE_PIXELS = 6.0f; // Body length on screen below which a mosquito is a point
+const int SILHOUETTE_VERTICES = 8;
+int windowWidth = 800;                  // Pixels across the window, kept by reshape()
+std::vector<float> swarmVertices;       // Batch scratch: positions, 2 floats per vertex
+std::vector<float> swarmColors;         // Batch scratch: colours, 4 floats per vertex
+
+// Large swarms are drawn as a density map instead of one mosquito at a time:
+// positions are binned into a histogram and shown as a single texture, so
+// drawing costs the same however many mosquitoes there are
+enum SwarmView {
+    VIEW_AUTO,    // Density map once the swarm passes densityThreshold
+    VIEW_AGENTS,  // Always draw every mosquito
+    VIEW_DENSITY  // Always draw the density map
+};
+const int DENSITY_MAP_SIZE = 128;
+SwarmView swarmView = VIEW_AUTO;
+int densityThreshold = 5000;            // Alive mosquitoes at which VIEW_AUTO switches
+Heatmap densityMap;
+std::vector<float> densityBins;         // Per-thread histograms, summed into densityMap
+bool densityMapDirty = true;
+
+// Worker threads for the simulation step
+JobSystem jobs;
+
+// Random streams; the seed is fixed once at startup so a run can be replayed
+uint64_t randomSeed = 0;
+Random swarmRandom;
+Random sprayRandom;
+
+// Variables for pond and water bowl
 bool waterBowlVisible = false;
-bool spraying = false;
-float sprayX = 0.0f, sprayY = 0.0f, sprayRadius = 0.08f;
 float waterBowlX = -0.4f, waterBowlY = -0.9f, waterBowlRadius = 0.05f;
 
-// Function to initialize mosquitoes with random positions and directions
+// Every active spray and its droplets
+SpraySystem sprays;
+
+// Droplet vertex and colour arrays, refilled each frame from the live list
+std::vector<float> dropletVertices(MAX_DROPLETS * 2);
+std::vector<float> dropletColors(MAX_DROPLETS * 4);
+
+// Death animation rate (per second)
+const float DEATH_FADE_RATE = 1.0f;
+
+// Simulation runs at a fixed rate; rendering runs at its own rate and
+// interpolates between the last two simulation states
+int simulationRate = 20;          // Simulation steps per second
+int renderRate = 60;              // Frames per second requested from the timer
+const float MAX_FRAME_TIME = 0.25f; // Longest real time one frame may catch up on
+float simAccumulator = 0.0f;      // Real time not yet consumed by simulation steps
+float renderAlpha = 1.0f;         // Blend factor between previous and current state
+std::chrono::steady_clock::time_point lastFrameTime;
+int timerGeneration = 0;          // Timers carrying an older value are stale and stop
+const int IDLE_TIMER_MS = 60000;  // Longest a settled scene sleeps between checks
+
+// Static render layers, recorded once into display lists and replayed every frame
+enum Layer {
+    LAYER_BACKGROUND, // Sky, clouds, houses, trees and pond (under the mosquitoes)
+    LAYER_OVERLAY,    // Title, instructions and alive counter (over everything)
+    NUM_LAYERS
+};
+GLuint layerLists = 0;
+bool layersDirty = true; // Set on resize; layers are rebuilt before the next frame
+
+// Phases timed by the profiler overlay (P toggles it)
+enum ProfilePhase {
+    PHASE_SPRAY,      // Droplet update and hit grid
+    PHASE_SWARM,      // Mosquito flight, spray hits and egg laying
+    PHASE_BROOD,      // Eggs and larvae
+    PHASE_EPIDEMIC,   // Bites and the household stencil
+    PHASE_BACKGROUND, // Static background layer
+    PHASE_MOSQUITOES, // Alive and dying mosquitoes
+    PHASE_EFFECTS,    // Water bowl and droplets
+    PHASE_TEXT,       // Labels and overlay layer
+    PHASE_PRESENT,    // Buffer swap
+    NUM_PHASES
+};
+const char* const PHASE_NAMES[NUM_PHASES] = {
+    "Spray", "Swarm", "Brood", "Epidemic", "Background", "Mosquitoes", "Effects", "Text", "Present"
+};
+
+// Alive counter label; re-recorded only when the count changes
+TextLabel countLabel;
+int shownAliveCount = -1;
+
+// Life-cycle label; re-recorded only when the day or brood counts change
+TextLabel populationLabel;
+int shownDay = -1;
+int shownEggs = -1;
+int shownLarvae = -1;
+bool shownFastForward = false;
+
+// Epidemic label; re-recorded only when the shown percentages change
+TextLabel epidemicLabel;
+int shownInfected = -1; // Tenths of a percent
+int shownRecovered = -1;
+
+// Function to get the latest simulated swarm state
+Mosquito* currentSwarm() {
+    return swarmStates[frontState].data();
+}
+
+// Function to get the swarm state one step before the latest
+Mosquito* previousSwarm() {
+    return swarmStates[1 - frontState].data();
+}
+
+// Function to restart every random stream from one seed
+void seedRandomStreams(uint64_t seed) {
+    randomSeed = seed;
+    swarmRandom.seed(seed, STREAM_SWARM);
+    sprayRandom.seed(seed, STREAM_SPRAY);
+    sprays.random.seed(seed, STREAM_DROPLETS);
+    broodRandom.seed(seed, STREAM_BROOD);
+    epidemicRandom.seed(seed, STREAM_EPIDEMIC);
+}
+
+// Function to bring a mosquito of the given age to life in `slot` at (x, y)
+void spawnMosquito(int slot, float x, float y, float age, bool infectious = false) {
+    Mosquito& m = currentSwarm()[slot];
+    m.x = x;
+    m.y = y;
+    m.dx = swarmRandom.range(-0.1f, 0.0f); // Slow random x velocity
+    m.dy = swarmRandom.range(-0.1f, 0.0f); // Slow random y velocity
+    m.size = MOSQUITO_SIZE; // Fixed small size
+    m.alive = true;
+    m.deathTimer = 0.0f;
+    m.age = age;
+    m.lifespan = swarmRandom.range(ADULT_LIFESPAN_MIN, ADULT_LIFESPAN_MAX);
+    m.infectious = infectious;
+    previousSwarm()[slot] = m; // No motion to blend on the first frame
+    aliveList.push_back(slot);
+}
+
+// Function to initialize mosquitoes with random positions and directions.
+// The swarm stream carries on across resets, so each reset gives a new layout.
 void initializeMosquitoes() {
-    srand(static_cast<unsigned>(time(0)));
-    aliveMosquitoes = NUM_MOSQUITOES;
-    for (int i = 0; i < NUM_MOSQUITOES; i++) {
-        mosquitoes[i].x = ((rand() % 200) / 100.0f) - 1.0f; // Random x position (-1 to 1)
-        mosquitoes[i].y = ((rand() % 200) / 100.0f) - 1.0f; // Random y position (-1 to 1)
-        mosquitoes[i].dx = ((rand() % 50) / 10000.0f) - 0.005f; // Slow random x direction
-        mosquitoes[i].dy = ((rand() % 50) / 10000.0f) - 0.005f; // Slow random y direction
-        mosquitoes[i].size = 0.05f; // Fixed small size
-        mosquitoes[i].alive = true; // All mosquitoes start alive
-        mosquitoes[i].deathTimer = 0.0f;
+    swarmStates[0].resize(swarmSize);
+    swarmStates[1].resize(swarmSize);
+    aliveList.clear();
+    dyingList.clear();
+    freeList.clear();
+    swarmPackedX.reserve(swarmSize);
+    swarmPackedY.reserve(swarmSize);
+    swarmSortedDx.reserve(swarmSize);
+    swarmSortedDy.reserve(swarmSize);
+    swarmGrid.configure(-1.0f, -1.0f, 1.0f, 1.0f, NEIGHBOUR_RADIUS);
+    aliveList.reserve(swarmSize); // Lists never grow past the pool
+    dyingList.reserve(swarmSize);
+    freeList.reserve(swarmSize);
+    for (int i = 0; i < swarmSize; i++) {
+        float x = swarmRandom.range(-1.0f, 1.0f); // Random x position (-1 to 1)
+        float y = swarmRandom.range(-1.0f, 1.0f); // Random y position (-1 to 1)
+        spawnMosquito(i, x, y, swarmRandom.range(0.0f, ADULT_LIFESPAN_MIN), // Mixed ages
+            epidemicRandom.nextFloat() < infectiousFraction);
+    }
+    aliveMosquitoes = (int)aliveList.size();
+
+    // Fresh water and no brood
+    sites[SITE_POND].x = 0.7f;
+    sites[SITE_POND].y = -0.85f;
+    sites[SITE_POND].larvaCapacity = 2.0f * swarmSize;
+    sites[SITE_BOWL].x = waterBowlX;
+    sites[SITE_BOWL].y = waterBowlY;
+    sites[SITE_BOWL].larvaCapacity = 0.5f * swarmSize;
+    for (int s = 0; s < NUM_SITES; s++) {
+        sites[s].eggs = 0;
+        sites[s].larvae = 0;
+        eggCarry[s] = 0.0f;
+    }
+    brood.clear();
+
+    // Nobody infected yet
+    if (epidemic.width != householdColumns || epidemic.height != householdRows) {
+        epidemic.configure(householdColumns, householdRows, -1.0f, -1.0f, 1.0f, 1.0f);
+    } else {
+        epidemic.clear();
+    }
+    infectionMapDirty = true;
+    simDay = 0.0;
+    simTick = 0;
+}
+
+// Function to find the wet breeding site nearest to (x, y); returns -1 when
+// everything is dry, otherwise the site and the offset to it in (ox, oy)
+int nearestWetSite(float x, float y, float& ox, float& oy) {
+    int best = -1;
+    float best2 = 0.0f;
+    for (int s = 0; s < NUM_SITES; s++) {
+        if (!sites[s].wet) continue;
+        float sx = sites[s].x - x, sy = sites[s].y - y;
+        float d2 = sx * sx + sy * sy;
+        if (best < 0 || d2 < best2) {
+            best = s;
+            best2 = d2;
+            ox = sx;
+            oy = sy;
+        }
+    }
+    return best;
+}
+
+// Function to lay `count` eggs at a breeding site
+void layEggs(int site, int count) {
+    for (int n = 0; n < count; n++) {
+        brood.add(STAGE_EGG, site, broodRandom.range(EGG_HATCH_MIN, EGG_HATCH_MAX));
     }
 }
 
-// Function to check if a mosquito is within spray range
-bool isInSprayRange(float mx, float my, float sx, float sy, float radius) {
-    float distance = sqrt((mx - sx) * (mx - sx) + (my - sy) * (my - sy));
-    return distance <= radius;
+// Function to spawn adults that emerged at a site into free slots; any
+// that find the swarm full are lost
+void emergeAt(int site, int count) {
+    for (int n = 0; n < count && !freeList.empty(); n++) {
+        int slot = freeList.back();
+        freeList.pop_back();
+        spawnMosquito(slot, sites[site].x + swarmRandom.range(-BREED_SPREAD, BREED_SPREAD),
+            sites[site].y + swarmRandom.range(0.0f, BREED_SPREAD), 0.0f);
+    }
 }
 
 // Function to draw a small mosquito
@@ -56,14 +351,7 @@ void drawMosquito(float x, float y, float size, float alpha = 1.0f) {
 
     // Head
     glColor4f(0.2f, 0.2f, 0.2f, alpha);
-    glBegin(GL_TRIANGLE_FAN);
-    glVertex2f(x - size / 2 - size / 4, y);
-    for (int i = 0; i <= 360; i++) {
-        float angle = i * (3.14159f / 180.0f);
-        glVertex2f(x - size / 2 - size / 4 + (size / 4) * cos(angle),
-            y + (size / 4) * sin(angle));
-    }
-    glEnd();
+    drawDisc2D(unitCircle(ROUND_SEGMENTS), x - size / 2 - size / 4, y, size / 4);
 
     // Wings
     glColor4f(0.5f, 0.5f, 0.5f, alpha);
@@ -137,113 +425,472 @@ void drawTree(float x, float y) {
 void drawPond() {
     glColor3f(0.0f, 0.0f, 1.0f); // Blue color for water
     glBegin(GL_POLYGON);
-    for (int i = 0; i < 360; i++) {
-        float angle = i * 3.14159f / 180.0f;
-        glVertex2f(0.7f + 0.3f * cos(angle), -0.85f + 0.2f * sin(angle)); // Pond shape
-    }
+    emitEllipse2D(unitCircle(ROUND_SEGMENTS), 0.7f, -0.85f, 0.3f, 0.2f, false); // Pond shape
     glEnd();
 }
 
 // Function to get random spray position near houses
 void getHouseSprayPosition(float& x, float& y) {
-    int houseChoice = rand() % 3; // Choose one of 3 houses
+    int houseChoice = sprayRandom.below(3); // Choose one of 3 houses
     switch (houseChoice) {
     case 0: // House 1 area
-        x = -0.9f + (rand() % 40) / 100.0f; // Around house 1 (-0.9 to -0.5)
-        y = -0.8f + (rand() % 40) / 100.0f; // Around house 1 base
+        x = -0.9f + sprayRandom.range(0.0f, 0.4f); // Around house 1 (-0.9 to -0.5)
+        y = -0.8f + sprayRandom.range(0.0f, 0.4f); // Around house 1 base
         break;
     case 1: // House 2 area  
-        x = -0.5f + (rand() % 50) / 100.0f; // Around house 2 (-0.5 to 0.0)
-        y = -0.8f + (rand() % 50) / 100.0f; // Around house 2 base
+        x = -0.5f + sprayRandom.range(0.0f, 0.5f); // Around house 2 (-0.5 to 0.0)
+        y = -0.8f + sprayRandom.range(0.0f, 0.5f); // Around house 2 base
         break;
     case 2: // House 3 area
-        x = 0.0f + (rand() % 35) / 100.0f; // Around house 3 (0.0 to 0.35)
-        y = -0.8f + (rand() % 35) / 100.0f; // Around house 3 base
+        x = 0.0f + sprayRandom.range(0.0f, 0.35f); // Around house 3 (0.0 to 0.35)
+        y = -0.8f + sprayRandom.range(0.0f, 0.35f); // Around house 3 base
         break;
     }
 }
-void updateMosquitoes() {
-    for (int i = 0; i < NUM_MOSQUITOES; i++) {
-        if (mosquitoes[i].alive) {
-            mosquitoes[i].x += mosquitoes[i].dx;
-            mosquitoes[i].y += mosquitoes[i].dy;
+// Function to work out how mosquito `m`, found at position `self` in the
+// grid's cell order, wants to change its velocity: separation, cohesion and
+// alignment from its neighbours, a pull towards water and a push away from
+// nearby spray. Writes the acceleration to (ax, ay).
+void steerMosquito(const Mosquito& m, int self, bool spraying, float& ax, float& ay) {
+    float sepX = 0.0f, sepY = 0.0f;
+    float sumX = 0.0f, sumY = 0.0f;
+    float sumDx = 0.0f, sumDy = 0.0f;
+    int neighbours = 0;
+    const float r2 = NEIGHBOUR_RADIUS * NEIGHBOUR_RADIUS;
+    const float s2 = SEPARATION_RADIUS * SEPARATION_RADIUS;
+
+    // Branch-free accumulation: whether a point counts is random from one
+    // visit to the next, so masks are cheaper than mispredicted branches
+    swarmGrid.forEachNear(m.x, m.y, NEIGHBOUR_RADIUS, [&](int other, float ox, float oy) {
+        float offX = m.x - ox;
+        float offY = m.y - oy;
+        float d2 = offX * offX + offY * offY;
+        float inside = (d2 < r2 && other != self) ? 1.0f : 0.0f;
+        float push = d2 < s2 ? inside / (d2 + 1e-6f) : 0.0f;
+        sepX += offX * push;
+        sepY += offY * push;
+        sumX += ox * inside;
+        sumY += oy * inside;
+        sumDx += swarmSortedDx[other] * inside;
+        sumDy += swarmSortedDy[other] * inside;
+        neighbours += (int)inside;
+        return neighbours < MAX_NEIGHBOURS;
+    });
 
-            // Reverse direction if mosquito hits a boundary
-            if (mosquitoes[i].x < -1.0f || mosquitoes[i].x > 1.0f)
-                mosquitoes[i].dx = -mosquitoes[i].dx;
-            if (mosquitoes[i].y < -1.0f || mosquitoes[i].y > 1.0f)
-                mosquitoes[i].dy = -mosquitoes[i].dy;
+    ax = sepX * SEPARATION_WEIGHT;
+    ay = sepY * SEPARATION_WEIGHT;
+    if (neighbours > 0) {
+        float inv = 1.0f / neighbours;
+        ax += (sumX * inv - m.x) * COHESION_WEIGHT + (sumDx * inv - m.dx) * ALIGNMENT_WEIGHT;
+        ay += (sumY * inv - m.y) * COHESION_WEIGHT + (sumDy * inv - m.dy) * ALIGNMENT_WEIGHT;
+    }
+
+    // Head for the nearest water when far from it
+    float waterX = 0.0f, waterY = 0.0f;
+    float water2 = 0.0f;
+    if (nearestWetSite(m.x, m.y, waterX, waterY) >= 0) {
+        water2 = waterX * waterX + waterY * waterY;
+    }
+    if (water2 > WATER_COMFORT_RADIUS * WATER_COMFORT_RADIUS) {
+        float inv = WATER_WEIGHT / sqrtf(water2);
+        ax += waterX * inv;
+        ay += waterY * inv;
+    }
 
-            // Check if mosquito is hit by spray
-            if (spraying && isInSprayRange(mosquitoes[i].x, mosquitoes[i].y, sprayX, sprayY, sprayRadius)) {
-                mosquitoes[i].alive = false;
-                mosquitoes[i].deathTimer = 1.0f; // Start death animation
-                aliveMosquitoes--;
+    // Flee from the droplets in sensing range
+    if (spraying) {
+        float awayX = 0.0f, awayY = 0.0f;
+        int seen = 0;
+        const float sense2 = SPRAY_SENSE_RADIUS * SPRAY_SENSE_RADIUS;
+        sprays.hitGrid.forEachNear(m.x, m.y, SPRAY_SENSE_RADIUS, [&](int, float ox, float oy) {
+            float offX = m.x - ox;
+            float offY = m.y - oy;
+            if (offX * offX + offY * offY < sense2) {
+                awayX += offX;
+                awayY += offY;
+                seen++;
             }
+            return seen < MAX_NEIGHBOURS;
+        });
+        float away2 = awayX * awayX + awayY * awayY;
+        if (away2 > 1e-12f) {
+            float inv = SPRAY_AVOID_WEIGHT / sqrtf(away2);
+            ax += awayX * inv;
+            ay += awayY * inv;
         }
-        else if (mosquitoes[i].deathTimer > 0.0f) {
-            // Handle death animation
-            mosquitoes[i].deathTimer -= 0.05f;
-            if (mosquitoes[i].deathTimer <= 0.0f) {
-                mosquitoes[i].deathTimer = 0.0f;
+    }
+}
+
+// Function to keep a velocity between MIN_SPEED and MAX_SPEED
+void clampSpeed(float& dx, float& dy) {
+    float speed2 = dx * dx + dy * dy;
+    if (speed2 > MAX_SPEED * MAX_SPEED) {
+        float scale = MAX_SPEED / sqrtf(speed2);
+        dx *= scale;
+        dy *= scale;
+    } else if (speed2 < MIN_SPEED * MIN_SPEED && speed2 > 1e-12f) {
+        float scale = MIN_SPEED / sqrtf(speed2);
+        dx *= scale;
+        dy *= scale;
+    }
+}
+
+// Function to build the neighbour grid from the alive mosquitoes in `state`,
+// with their velocities copied into the same cell order
+void buildSwarmGrid(const Mosquito* state) {
+    int n = (int)aliveList.size();
+    swarmPackedX.resize(n);
+    swarmPackedY.resize(n);
+    for (int k = 0; k < n; k++) {
+        swarmPackedX[k] = state[aliveList[k]].x;
+        swarmPackedY[k] = state[aliveList[k]].y;
+    }
+    swarmGrid.build(swarmPackedX.data(), swarmPackedY.data(), n, 1, aliveList.data());
+
+    swarmSortedDx.resize(n);
+    swarmSortedDy.resize(n);
+    for (int k = 0; k < n; k++) {
+        const Mosquito& m = state[swarmGrid.items[k]];
+        swarmSortedDx[k] = m.dx;
+        swarmSortedDy[k] = m.dy;
+    }
+}
+
+// Per-chunk results of the alive mosquito update
+struct SwarmTally {
+    int died;                 // Killed by spray or old age
+    int layers[NUM_SITES];    // Adults laying at each site
+};
+
+// Function to advance alive mosquitoes from `src` into `dst` by dt seconds
+// and `days` of age. The range [begin, end) indexes the neighbour grid's
+// cell order, so each chunk works on a compact patch of space.
+SwarmTally updateAliveChunk(const Mosquito* src, Mosquito* dst, int begin, int end, float dt, float days, bool spraying) {
+    SwarmTally tally = {};
+    const int* slots = swarmGrid.items.data();
+    for (int k = begin; k < end; k++) {
+        int i = slots[k];
+        Mosquito m = src[i];
+        float ax, ay;
+        steerMosquito(m, k, spraying, ax, ay);
+        m.dx += ax * dt;
+        m.dy += ay * dt;
+        clampSpeed(m.dx, m.dy);
+        m.x += m.dx * dt;
+        m.y += m.dy * dt;
+
+        // Reverse direction if mosquito hits a boundary
+        if (m.x < -1.0f || m.x > 1.0f)
+            m.dx = -m.dx;
+        if (m.y < -1.0f || m.y > 1.0f)
+            m.dy = -m.dy;
+
+        // Check if mosquito is hit by a spray droplet or dies of age
+        m.age += days;
+        if ((spraying && sprays.hits(m.x, m.y)) || m.age >= m.lifespan) {
+            m.alive = false;
+            m.deathTimer = 1.0f; // Start death animation
+            tally.died++;
+        } else {
+            float ox, oy;
+            int site = nearestWetSite(m.x, m.y, ox, oy);
+            if (site >= 0) tally.layers[site]++;
+        }
+        dst[i] = m;
+    }
+    return tally;
+}
+
+// Function to advance the death animation of dying mosquitoes list[begin..end)
+void updateDyingChunk(const int* list, const Mosquito* src, Mosquito* dst, int begin, int end, float dt) {
+    for (int k = begin; k < end; k++) {
+        int i = list[k];
+        Mosquito m = src[i];
+        m.deathTimer -= DEATH_FADE_RATE * dt;
+        if (m.deathTimer <= 0.0f) {
+            m.deathTimer = 0.0f;
+        }
+        dst[i] = m;
+    }
+}
+
+// Function to move slots whose state no longer matches their list:
+// newly killed ones to the dying list, finished ones to the free list
+void compactSwarmLists(const Mosquito* state, bool anyKilled) {
+    if (anyKilled) {
+        for (size_t k = 0; k < aliveList.size();) {
+            int i = aliveList[k];
+            if (!state[i].alive) {
+                dyingList.push_back(i);
+                aliveList[k] = aliveList.back();
+                aliveList.pop_back();
+            } else {
+                k++;
             }
         }
     }
+    for (size_t k = 0; k < dyingList.size();) {
+        int i = dyingList[k];
+        if (state[i].deathTimer <= 0.0f) {
+            freeList.push_back(i);
+            dyingList[k] = dyingList.back();
+            dyingList.pop_back();
+        } else {
+            k++;
+        }
+    }
+}
+
+// Function to advance the mosquitoes by one simulation step of dt seconds
+// and `days` of age. Chunks of the alive and dying lists run across the job
+// system; deaths and layers are summed from the per-chunk results, then the
+// lists are compacted and the adults lay their eggs.
+void updateMosquitoes(float dt, float days) {
+    const bool spraying = sprays.active();
+    const Mosquito* src = currentSwarm();
+    Mosquito* dst = previousSwarm();
+
+    buildSwarmGrid(src);
+
+    const int* dying = dyingList.data();
+    jobs.parallelFor((int)dyingList.size(), SWARM_CHUNK_SIZE, [=](int begin, int end) {
+        updateDyingChunk(dying, src, dst, begin, end, dt);
+    });
+    SwarmTally tally = jobs.parallelReduce((int)aliveList.size(), SWARM_CHUNK_SIZE, SwarmTally(),
+        [=](int begin, int end) { return updateAliveChunk(src, dst, begin, end, dt, days, spraying); },
+        [](SwarmTally a, const SwarmTally& b) {
+            a.died += b.died;
+            for (int s = 0; s < NUM_SITES; s++) a.layers[s] += b.layers[s];
+            return a;
+        });
+
+    frontState = 1 - frontState;
+    compactSwarmLists(currentSwarm(), tally.died > 0);
+
+    if (breedingEnabled) {
+        for (int s = 0; s < NUM_SITES; s++) {
+            eggCarry[s] += tally.layers[s] * EGGS_PER_ADULT_DAY * days;
+            int eggs = (int)eggCarry[s];
+            eggCarry[s] -= eggs;
+            layEggs(s, eggs);
+        }
+    }
+    aliveMosquitoes = (int)aliveList.size();
+}
+
+// Function to age the eggs and larvae by `days` and release new adults
+void updateBrood(float days) {
+    BroodTally tally = stepBrood(brood, sites, NUM_SITES, days, randomSeed, simTick, jobs);
+    for (int s = 0; s < NUM_SITES; s++) {
+        emergeAt(s, tally.emerged[s]);
+    }
+    aliveMosquitoes = (int)aliveList.size();
+}
+
+// Function to let each alive mosquito bite the household under it with a
+// chance of BITES_PER_DAY * days. Infectious mosquitoes expose a person;
+// the others may pick the virus up from an infectious one. Runs on one
+// thread in alive-list order so runs replay exactly.
+void biteHouseholds(float days) {
+    float biteChance = BITES_PER_DAY * days;
+    Mosquito* mosquitoes = currentSwarm();
+    for (size_t k = 0; k < aliveList.size(); k++) {
+        Mosquito& m = mosquitoes[aliveList[k]];
+        if (epidemicRandom.nextFloat() >= biteChance) continue;
+        size_t cell = epidemic.cellAt(m.x, m.y);
+        if (m.infectious) {
+            epidemic.expose(cell);
+        } else if (epidemicRandom.nextFloat() < epidemic.infectiousAt(cell) * MOSQUITO_ACQUIRE) {
+            m.infectious = true;
+        }
+    }
+}
+
+// Function to advance the whole simulation by one fixed step
+void stepSimulation(float dt) {
+    float days = dt * daysPerSecond * (fastForward ? FAST_FORWARD_FACTOR : 1.0f);
+    sites[SITE_BOWL].wet = !waterBowlVisible; // The bowl still holds water
+    sites[SITE_POND].wet = true;
+
+    {
+        PROFILE_SCOPE(PHASE_SPRAY);
+        sprays.step(dt, jobs); // Droplets first, so mosquitoes meet this step's spray
+    }
+    {
+        PROFILE_SCOPE(PHASE_SWARM);
+        updateMosquitoes(dt, days);
+    }
+    {
+        PROFILE_SCOPE(PHASE_BROOD);
+        updateBrood(days);
+    }
+    {
+        PROFILE_SCOPE(PHASE_EPIDEMIC);
+        biteHouseholds(days);
+        stepEpidemic(epidemic, days, jobs);
+        infectionMapDirty = true;
+    }
+    densityMapDirty = true;
+    simDay += days;
+    simTick++;
+}
+
+// Function to start a new spray near a random house; several can run at once
+void startSpray() {
+    float x, y;
+    getHouseSprayPosition(x, y);
+    sprays.addEmitter(x, y);
+}
+
+// Function to blend a value between the previous and current simulation state
+float interpolate(float previous, float current) {
+    return previous + (current - previous) * renderAlpha;
+}
+
+// Function to blend a dying mosquito's fade. A mosquito killed in the last
+// step was still alive in the previous state, where its timer reads 0;
+// count that as the full 1 the fade starts from, so it doesn't flicker.
+float interpolateFade(const Mosquito& previous, const Mosquito& current) {
+    return interpolate(previous.alive ? 1.0f : previous.deathTimer, current.deathTimer);
 }
 
 // Function to display text on the screen
 void displayText(const char* text, float x, float y) {
     glColor3f(0.0f, 0.0f, 0.0f); // Black text
     glRasterPos2f(x, y);
-    for (int i = 0; i < strlen(text); i++) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_18, text[i]);
-    }
+    emitBitmapString(GLUT_BITMAP_HELVETICA_18, text);
 }
 
-// Function to display instructions
-void displayInstructions() {
-    // Define the multiple lines of text
-    const char* instructions[] = {
-        "Please Press :",
-        " S: Start Spray Effect",
-        " R: Remove Water from the Bowl",
-        " N: Reset Mosquitoes",
-        "",
-        "Instructions:",
-        "1. Keep water clean,",
-        "2. cover containers,",
-        "3. wear protective clothes."
-    };
+// Static instruction lines, down the right of the window from the top
+const char* const INSTRUCTIONS[] = {
+    "Please Press :",
+    " S: Start Spray Effect",
+    " R: Remove Water from the Bowl",
+    " N: Reset Mosquitoes",
+    " F: Fast-forward Life Cycle",
+    " H: Show Infection Map",
+    " D: Switch Swarm View",
+    " P: Show Frame Timings",
+    "",
+    "Instructions:",
+    "1. Keep water clean,",
+    "2. cover containers,",
+    "3. wear protective clothes."
+};
+const int NUM_INSTRUCTIONS = (int)(sizeof(INSTRUCTIONS) / sizeof(INSTRUCTIONS[0]));
+const float TEXT_TOP = 0.9f;      // Height of the first instruction line
+const float TEXT_SPACING = 0.05f; // Distance between lines
+
+// Function to get the height of line `line` in the right-hand column. The
+// counter labels take the lines after the instructions, so adding a key
+// line moves them down with it.
+float textLineY(int line) {
+    return TEXT_TOP - TEXT_SPACING * line;
+}
 
-    float yPos = 0.9f;
-    for (int i = 0; i < 9; i++) {
-        displayText(instructions[i], 0.3f, yPos);
-        yPos -= 0.05f;  // Move to the next line
+// Function to display the static instruction lines
+void displayInstructions() {
+    for (int i = 0; i < NUM_INSTRUCTIONS; i++) {
+        displayText(INSTRUCTIONS[i], 0.3f, textLineY(i));
     }
+}
 
-    // Display mosquito count
+// Function to refresh the mosquito count label when the count has changed
+void updateMosquitoCount() {
+    if (aliveMosquitoes == shownAliveCount) {
+        return;
+    }
     char mosquitoCount[50];
-    sprintf(mosquitoCount, "Alive Mosquitoes: %d", aliveMosquitoes);
-    displayText(mosquitoCount, 0.3f, 0.4f);
+    snprintf(mosquitoCount, sizeof(mosquitoCount), "Alive Mosquitoes: %d", aliveMosquitoes);
+    setLabelText(countLabel, mosquitoCount);
+    shownAliveCount = aliveMosquitoes;
+}
+
+// Function to refresh the life-cycle label when its numbers have changed
+void updatePopulationLabel() {
+    int day = (int)simDay;
+    int eggs = 0, larvae = 0;
+    for (int s = 0; s < NUM_SITES; s++) {
+        eggs += sites[s].eggs;
+        larvae += sites[s].larvae;
+    }
+    if (day == shownDay && eggs == shownEggs && larvae == shownLarvae && fastForward == shownFastForward) {
+        return;
+    }
+    char text[80];
+    snprintf(text, sizeof(text), "Day %d  Eggs: %d  Larvae: %d%s", day, eggs, larvae,
+        fastForward ? "  (fast-forward)" : "");
+    setLabelText(populationLabel, text);
+    shownDay = day;
+    shownEggs = eggs;
+    shownLarvae = larvae;
+    shownFastForward = fastForward;
+}
+
+// Function to refresh the epidemic label when its percentages have changed
+void updateEpidemicLabel() {
+    double people = (double)epidemic.cellCount();
+    const EpidemicTotals& totals = epidemic.totals;
+    int infected = (int)(1000.0 * (totals.exposed + totals.infectious) / people + 0.5);
+    int recovered = (int)(1000.0 * (people - totals.susceptible - totals.exposed - totals.infectious) / people + 0.5);
+    if (infected == shownInfected && recovered == shownRecovered) {
+        return;
+    }
+    char text[80];
+    snprintf(text, sizeof(text), "Infected: %.1f%%  Recovered: %.1f%%", infected / 10.0f, recovered / 10.0f);
+    setLabelText(epidemicLabel, text);
+    shownInfected = infected;
+    shownRecovered = recovered;
+}
+
+// Function to draw the infection heatmap over the scene, resampling the
+// household grid first if a step has run since the last draw
+void drawInfectionMap() {
+    if (infectionMapDirty) {
+        sampleInfectious(epidemic, infectionMap.values.data(), infectionMap.width, infectionMap.height, jobs);
+        uploadHeatmap(infectionMap, INFECTION_MAP_SCALE);
+        infectionMapDirty = false;
+    }
+    drawHeatmap(infectionMap, -1.0f, -1.0f, 1.0f, 1.0f);
 }
 
 // Function to draw clouds in the sky
 void drawCloud(float x, float y) {
     glColor3f(1.0f, 1.0f, 1.0f); // White
     glBegin(GL_POLYGON);
-    for (int i = 0; i < 360; i += 10) {
-        float angle = i * 3.14159f / 180.0f;
-        glVertex2f(x + 0.1f * cos(angle), y + 0.1f * sin(angle));
-    }
+    emitEllipse2D(unitCircle(CLOUD_SEGMENTS), x, y, 0.1f, 0.1f, false);
     glEnd();
 }
 
-// Display function
-void display() {
-    glClear(GL_COLOR_BUFFER_BIT);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+// Function to draw every live spray droplet as one batch of points
+void drawDroplets() {
+    const DropletPool& pool = sprays.droplets;
+    if (pool.liveCount == 0) {
+        return;
+    }
+    for (int k = 0; k < pool.liveCount; k++) {
+        int i = pool.live[k];
+        dropletVertices[k * 2] = interpolate(pool.prevX[i], pool.x[i]);
+        dropletVertices[k * 2 + 1] = interpolate(pool.prevY[i], pool.y[i]);
+        dropletColors[k * 4] = 0.1f; // Light blue spray with transparency
+        dropletColors[k * 4 + 1] = 0.5f;
+        dropletColors[k * 4 + 2] = 1.0f;
+        dropletColors[k * 4 + 3] = 0.6f * pool.alpha[i];
+    }
+
+    glPointSize(3.0f);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, dropletVertices.data());
+    glColorPointer(4, GL_FLOAT, 0, dropletColors.data());
+    glDrawArrays(GL_POINTS, 0, pool.liveCount);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glPointSize(1.0f);
+}
 
+// Function to draw everything behind the mosquitoes; none of it ever moves
+void drawBackground() {
     // Draw background
     glColor3f(0.53f, 0.81f, 0.92f); // Sky blue
     glBegin(GL_QUADS);
@@ -270,70 +917,314 @@ void display() {
 
     // Draw pond
     drawPond();
+}
 
-    // Draw mosquitoes
-    for (int i = 0; i < NUM_MOSQUITOES; i++) {
-        if (mosquitoes[i].alive) {
-            drawMosquito(mosquitoes[i].x, mosquitoes[i].y, mosquitoes[i].size);
+// Function to draw the static text shown over the scene
+void drawStaticText() {
+    displayText("Dengue Awareness: Mosquitoes", -0.9f, 0.9f);
+    displayInstructions();
+}
+
+// Function to record the static layers into display lists
+void buildLayers() {
+    if (layerLists == 0) {
+        layerLists = glGenLists(NUM_LAYERS);
+    }
+
+    glNewList(layerLists + LAYER_BACKGROUND, GL_COMPILE);
+    drawBackground();
+    glEndList();
+
+    glNewList(layerLists + LAYER_OVERLAY, GL_COMPILE);
+    drawStaticText();
+    drawLabel(countLabel); // Recorded as calls, so label changes show through
+    drawLabel(populationLabel);
+    drawLabel(epidemicLabel);
+    glEndList();
+
+    layersDirty = false;
+}
+
+// Function to replay a recorded static layer
+void drawLayer(Layer layer) {
+    glCallList(layerLists + layer);
+}
+
+// Function to pick the level of detail for mosquitoes of a given size
+MosquitoLod chooseLod(float size) {
+    float pixels = size * 0.5f * windowWidth; // The view spans 2 units across
+    if (pixels >= LOD_FULL_PIXELS) return LOD_FULL;
+    if (pixels >= LOD_SILHOUETTE_PIXELS) return LOD_SILHOUETTE;
+    return LOD_POINT;
+}
+
+// Function to write one batch vertex
+inline void setSwarmVertex(size_t vertex, float x, float y, float shade, float alpha) {
+    swarmVertices[vertex * 2] = x;
+    swarmVertices[vertex * 2 + 1] = y;
+    swarmColors[vertex * 4] = shade;
+    swarmColors[vertex * 4 + 1] = shade;
+    swarmColors[vertex * 4 + 2] = shade;
+    swarmColors[vertex * 4 + 3] = alpha;
+}
+
+// Function to fill the batch arrays for mosquitoes list[begin..end) of a
+// batch of `count` at `lod`, fading each by its death timer when `dying`.
+// Silhouettes put every wing triangle first and every body line after
+// them, so each part is one draw call.
+void fillSwarmBatch(const int* list, int begin, int end, int count, MosquitoLod lod, bool dying) {
+    // Silhouette outline in body lengths: two wing triangles, then the body
+    // line from the head to the tail
+    static const float shape[SILHOUETTE_VERTICES][2] = {
+        { 0.0f, 0.0f }, { -1.5f, 1.0f }, { -0.5f, 0.0f },
+        { 0.0f, 0.0f }, { 1.5f, 1.0f }, { 0.5f, 0.0f },
+        { -0.75f, 0.0f }, { 0.5f, 0.0f }
+    };
+    const Mosquito* previous = previousSwarm();
+    const Mosquito* mosquitoes = currentSwarm();
+    for (int k = begin; k < end; k++) {
+        int i = list[k];
+        float x = interpolate(previous[i].x, mosquitoes[i].x);
+        float y = interpolate(previous[i].y, mosquitoes[i].y);
+        float alpha = dying ? interpolateFade(previous[i], mosquitoes[i]) : 1.0f;
+        if (lod == LOD_POINT) {
+            setSwarmVertex(k, x, y, 0.0f, alpha);
+            continue;
+        }
+        float size = mosquitoes[i].size;
+        size_t wings = (size_t)k * 6;
+        size_t body = (size_t)count * 6 + (size_t)k * 2;
+        for (int n = 0; n < 6; n++) {
+            setSwarmVertex(wings + n, x + shape[n][0] * size, y + shape[n][1] * size, 0.5f, alpha);
         }
-        else if (mosquitoes[i].deathTimer > 0.0f) {
-            // Draw dying mosquito with fading effect
-            float alpha = mosquitoes[i].deathTimer;
-            drawMosquito(mosquitoes[i].x, mosquitoes[i].y, mosquitoes[i].size, alpha);
+        for (int n = 0; n < 2; n++) {
+            setSwarmVertex(body + n, x + shape[6 + n][0] * size, y + shape[6 + n][1] * size, 0.0f, alpha);
         }
     }
+}
 
-    // Draw water bowl if visible
-    if (!waterBowlVisible) {
-        glColor3f(0.0f, 0.0f, 1.0f);  // Blue water bowl
-        glBegin(GL_POLYGON);
-        for (int i = 0; i < 360; i++) {
-            float angle = i * 3.14159f / 180.0f;
-            glVertex2f(waterBowlX + waterBowlRadius * cos(angle), waterBowlY + waterBowlRadius * sin(angle));
+// Function to draw one batch of mosquitoes (the alive or the dying list)
+// at a single level of detail
+void drawSwarmBatch(const std::vector<int>& list, bool dying) {
+    int count = (int)list.size();
+    if (count == 0) {
+        return;
+    }
+    MosquitoLod lod = chooseLod(MOSQUITO_SIZE);
+    if (lod == LOD_FULL) {
+        const Mosquito* previous = previousSwarm();
+        const Mosquito* mosquitoes = currentSwarm();
+        for (int k = 0; k < count; k++) {
+            int i = list[k];
+            float alpha = dying ? interpolateFade(previous[i], mosquitoes[i]) : 1.0f;
+            drawMosquito(interpolate(previous[i].x, mosquitoes[i].x),
+                interpolate(previous[i].y, mosquitoes[i].y), mosquitoes[i].size, alpha);
         }
-        glEnd();
+        return;
     }
 
-    // Draw spray effect if active
-    if (spraying) {
-        glColor4f(0.1f, 0.5f, 1.0f, 0.6f);  // Light blue spray with transparency
-        glBegin(GL_TRIANGLE_FAN);
-        glVertex2f(sprayX, sprayY);
-        for (int i = 0; i <= 360; i++) {
-            float angle = i * 3.14159f / 180.0f;
-            glVertex2f(sprayX + sprayRadius * cos(angle), sprayY + sprayRadius * sin(angle));
-        }
-        glEnd();
-        sprayRadius += 0.01f;
-        if (sprayRadius > 0.2f) {
-            spraying = false;
+    // Arrays only grow, so steady frames don't allocate
+    int perAgent = lod == LOD_POINT ? 1 : SILHOUETTE_VERTICES;
+    size_t vertices = (size_t)count * perAgent;
+    if (swarmVertices.size() < vertices * 2) {
+        swarmVertices.resize(vertices * 2);
+        swarmColors.resize(vertices * 4);
+    }
+    const int* slots = list.data();
+    jobs.parallelFor(count, SWARM_CHUNK_SIZE * 4, [=](int begin, int end) {
+        fillSwarmBatch(slots, begin, end, count, lod, dying);
+    });
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, swarmVertices.data());
+    glColorPointer(4, GL_FLOAT, 0, swarmColors.data());
+    if (lod == LOD_POINT) {
+        float pixels = MOSQUITO_SIZE * 0.5f * windowWidth;
+        glPointSize(pixels > 2.0f ? 2.0f : 1.0f);
+        glDrawArrays(GL_POINTS, 0, count);
+        glPointSize(1.0f);
+    } else {
+        glDrawArrays(GL_TRIANGLES, 0, count * 6);
+        glDrawArrays(GL_LINES, count * 6, count * 2);
+    }
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+// Function to draw the alive and dying mosquitoes between the last two states
+void drawSwarm() {
+    drawSwarmBatch(aliveList, false);
+    drawSwarmBatch(dyingList, true); // Fading with their death timers
+}
+
+// Function to tell whether this frame draws the swarm as a density map
+bool showDensity() {
+    if (swarmView == VIEW_AUTO) {
+        return (int)aliveList.size() >= densityThreshold;
+    }
+    return swarmView == VIEW_DENSITY;
+}
+
+// Function to draw the alive mosquitoes as a density map, re-binning their
+// positions if a step has run since the last draw
+void drawDensity() {
+    if (densityMapDirty) {
+        const Mosquito* mosquitoes = currentSwarm();
+        const int* alive = aliveList.data();
+        float peak = binPoints(densityMap, densityBins, (int)aliveList.size(),
+            [=](int k, float& x, float& y) {
+                x = mosquitoes[alive[k]].x;
+                y = mosquitoes[alive[k]].y;
+            },
+            -1.0f, -1.0f, 1.0f, 1.0f, jobs);
+        uploadHeatmap(densityMap, peak > 0.0f ? 1.0f / peak : 0.0f);
+        densityMapDirty = false;
+    }
+    drawHeatmap(densityMap, -1.0f, -1.0f, 1.0f, 1.0f);
+}
+
+// Display function
+void display() {
+    frameStarted();
+    PROFILE_FRAME();
+    if (layersDirty) {
+        buildLayers();
+    }
+
+    glClear(GL_COLOR_BUFFER_BIT);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // Static scene behind the swarm
+    {
+        PROFILE_SCOPE(PHASE_BACKGROUND);
+        drawLayer(LAYER_BACKGROUND);
+    }
+
+    // Infection heatmap between the town and the swarm
+    if (infectionMapVisible) {
+        PROFILE_SCOPE(PHASE_EFFECTS);
+        drawInfectionMap();
+    }
+
+    // Draw mosquitoes
+    {
+        PROFILE_SCOPE(PHASE_MOSQUITOES);
+        if (showDensity()) {
+            drawDensity();
+        } else {
+            drawSwarm();
         }
     }
 
-    // Display text
-    displayText("Dengue Awareness: Mosquitoes", -0.9f, 0.9f);
+    {
+        PROFILE_SCOPE(PHASE_EFFECTS);
+        // Draw water bowl if visible
+        if (!waterBowlVisible) {
+            glColor3f(0.0f, 0.0f, 1.0f);  // Blue water bowl
+            glBegin(GL_POLYGON);
+            emitEllipse2D(unitCircle(ROUND_SEGMENTS), waterBowlX, waterBowlY, waterBowlRadius, waterBowlRadius, false);
+            glEnd();
+        }
 
-    // Display instructions
-    displayInstructions();
+        // Draw spray droplets
+        drawDroplets();
+    }
 
+    // Text over the scene in one batch
+    {
+        PROFILE_SCOPE(PHASE_TEXT);
+        updateMosquitoCount();
+        updatePopulationLabel();
+        updateEpidemicLabel();
+        drawLayer(LAYER_OVERLAY);
+    }
+
+    drawProfilerOverlay();
     glDisable(GL_BLEND);
+    PROFILE_SCOPE(PHASE_PRESENT);
     glutSwapBuffers();
 }
 
-// Timer function for animation
+// Function to tell whether the simulation has come to rest: nothing alive,
+// no brood, no spray and no infection left. From there only the day count
+// moves until a key changes something.
+bool simulationSettled() {
+    if (!aliveList.empty() || !dyingList.empty() || sprays.emitterCount > 0 || sprays.droplets.liveCount > 0) {
+        return false;
+    }
+    for (int s = 0; s < NUM_SITES; s++) {
+        if (sites[s].eggs > 0 || sites[s].larvae > 0) {
+            return false;
+        }
+    }
+    // The epidemic clears values below its floor, so it reaches exact zero
+    return epidemic.totals.exposed == 0.0 && epidemic.totals.infectious == 0.0;
+}
+
+// Timer function for animation: runs as many fixed simulation steps as the
+// elapsed real time allows, then redraws with the leftover as blend factor.
+// Once the simulation has settled it stops stepping and redrawing, and
+// only wakes when the day count next turns over.
 void timer(int value) {
-    updateMosquitoes();      // Update positions
-    glutPostRedisplay();     // Redraw the scene
-    glutTimerFunc(50, timer, 0); // Approx 20 FPS
+    if (value != timerGeneration) {
+        return; // Replaced by wakeTimer()
+    }
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    float frameTime = std::chrono::duration<float>(now - lastFrameTime).count();
+    lastFrameTime = now;
+
+    if (simulationSettled()) {
+        float daysPerRealSecond = daysPerSecond * (fastForward ? FAST_FORWARD_FACTOR : 1.0f);
+        int shownDay = (int)simDay;
+        simDay += frameTime * daysPerRealSecond;
+        simAccumulator = 0.0f;
+        if ((int)simDay != shownDay) {
+            requestRedraw();
+        }
+        double untilNextDay = (floor(simDay) + 1.0 - simDay) / daysPerRealSecond;
+        glutTimerFunc((unsigned int)std::min(untilNextDay * 1000.0 + 1.0, (double)IDLE_TIMER_MS), timer, value);
+        return;
+    }
+
+    if (frameTime > MAX_FRAME_TIME) {
+        frameTime = MAX_FRAME_TIME; // Don't spiral after a long stall
+    }
+
+    const float step = 1.0f / simulationRate;
+    simAccumulator += frameTime;
+    while (simAccumulator >= step) {
+        stepSimulation(step);
+        simAccumulator -= step;
+    }
+    renderAlpha = simAccumulator / step;
+
+    requestRedraw();
+    glutTimerFunc(1000 / renderRate, timer, value);
+}
+
+// Function to redraw and restart the frame timer at once, dropping any
+// sleeping one
+void wakeTimer() {
+    requestRedraw();
+    timerGeneration++;
+    glutTimerFunc(0, timer, timerGeneration);
+}
+
+// Reshape function; the static layers are re-recorded for the new size
+void reshape(int width, int height) {
+    glViewport(0, 0, width, height);
+    windowWidth = width;
+    layersDirty = true;
+    requestRedraw();
 }
 
 // Keyboard function
 void keyboard(unsigned char key, int x, int y) {
     if (key == 's' || key == 'S') {
         // Start spraying near houses only
-        getHouseSprayPosition(sprayX, sprayY);
-        sprayRadius = 0.08f;
-        spraying = true;
+        startSpray();
     }
 
     if (key == 'r' || key == 'R') {
@@ -345,6 +1236,29 @@ void keyboard(unsigned char key, int x, int y) {
         // Reset mosquitoes
         initializeMosquitoes();
     }
+
+    if (key == 'f' || key == 'F') {
+        // Speed up the life cycle
+        fastForward = !fastForward;
+    }
+
+    if (key == 'd' || key == 'D') {
+        // Cycle automatic, per-mosquito and density drawing
+        swarmView = (SwarmView)((swarmView + 1) % 3);
+    }
+
+    if (key == 'h' || key == 'H') {
+        // Show or hide the infection heatmap
+        infectionMapVisible = !infectionMapVisible;
+    }
+
+    if (key == 'p' || key == 'P') {
+        // Show or hide the frame timings
+        toggleProfilerOverlay();
+    }
+
+    // Whatever the key changed, a settled scene has to start moving again
+    wakeTimer();
 }
 
 // Initialization
@@ -353,11 +1267,178 @@ void init() {
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
     gluOrtho2D(-1.0, 1.0, -1.0, 1.0); // 2D orthographic projection
+    const int circleCounts[] = { ROUND_SEGMENTS, CLOUD_SEGMENTS };
+    warmCircleTables(circleCounts, 2);
+    initLabel(countLabel, GLUT_BITMAP_HELVETICA_18, 0.3f, textLineY(NUM_INSTRUCTIONS), 0.0f, 0.0f, 0.0f);
+    initLabel(populationLabel, GLUT_BITMAP_HELVETICA_18, 0.3f, textLineY(NUM_INSTRUCTIONS + 1), 0.0f, 0.0f, 0.0f);
+    initLabel(epidemicLabel, GLUT_BITMAP_HELVETICA_18, 0.3f, textLineY(NUM_INSTRUCTIONS + 2), 0.0f, 0.0f, 0.0f);
+    const float infectionLow[4] = { 1.0f, 0.9f, 0.2f, 0.3f };  // Pale yellow, faint
+    const float infectionHigh[4] = { 0.8f, 0.0f, 0.0f, 0.75f }; // Deep red
+    initHeatmap(infectionMap, INFECTION_MAP_SIZE, INFECTION_MAP_SIZE, infectionLow, infectionHigh);
+    const float densityLow[4] = { 0.3f, 0.3f, 0.3f, 0.35f }; // Light grey haze
+    const float densityHigh[4] = { 0.0f, 0.0f, 0.0f, 0.9f }; // Near-black swarm
+    initHeatmap(densityMap, DENSITY_MAP_SIZE, DENSITY_MAP_SIZE, densityLow, densityHigh);
+    profilerSetup(PHASE_NAMES, NUM_PHASES);
     initializeMosquitoes();
+    lastFrameTime = std::chrono::steady_clock::now();
+}
+
+// Settings for a headless benchmark run
+struct HeadlessConfig {
+    int ticks;              // Simulation steps to run
+    float days;             // When above zero, run until this many life-cycle days instead
+    int sprayEvery;         // Start a spray every this many ticks (0 = never)
+    std::vector<int> sprayAt; // Extra ticks at which a spray starts
+};
+
+// Function to parse a comma separated list of ticks, e.g. "10,50,120"
+void parseTickList(const char* text, std::vector<int>& ticks) {
+    while (*text != '\0') {
+        ticks.push_back(atoi(text));
+        const char* comma = strchr(text, ',');
+        if (!comma) break;
+        text = comma + 1;
+    }
+}
+
+// Function to run the simulation without a window as fast as possible and
+// report its throughput
+int runHeadless(const HeadlessConfig& config) {
+    initializeMosquitoes();
+    profilerSetup(PHASE_NAMES, NUM_PHASES); // Only the simulation phases get time here
+
+    const float step = 1.0f / simulationRate;
+    size_t nextScripted = 0;
+    int peakDroplets = 0;
+    double agentTicks = 0.0; // Alive and dying mosquitoes processed, summed over ticks
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    int tick = 0;
+    int reportedDay = 0;
+    for (; config.days > 0.0f ? simDay < config.days : tick < config.ticks; tick++) {
+        bool sprayNow = config.sprayEvery > 0 && tick % config.sprayEvery == 0;
+        while (nextScripted < config.sprayAt.size() && config.sprayAt[nextScripted] <= tick) {
+            sprayNow = sprayNow || config.sprayAt[nextScripted] == tick;
+            nextScripted++;
+        }
+        if (sprayNow) {
+            startSpray();
+        }
+        agentTicks += (double)(aliveList.size() + dyingList.size());
+        PROFILE_FRAME();
+        stepSimulation(step);
+        if (sprays.droplets.liveCount > peakDroplets) {
+            peakDroplets = sprays.droplets.liveCount;
+        }
+        if (config.days > 0.0f && (int)simDay > reportedDay) {
+            reportedDay = (int)simDay;
+            printf("Day %3d: adults %d, eggs %d, larvae %d, people infected %.2f%%\n", reportedDay, aliveMosquitoes,
+                sites[SITE_POND].eggs + sites[SITE_BOWL].eggs, sites[SITE_POND].larvae + sites[SITE_BOWL].larvae,
+                100.0 * (epidemic.totals.exposed + epidemic.totals.infectious) / epidemic.cellCount());
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("Mosquitoes:       %d\n", swarmSize);
+    printf("Ticks:            %d (%.3f s simulated, %.2f days)\n", tick, tick * step, simDay);
+    printf("Threads:          %d\n", jobs.threadCount());
+    printf("Seed:             %llu\n", (unsigned long long)randomSeed);
+    printf("Wall time:        %.3f s\n", seconds);
+    printf("Ticks/sec:        %.1f\n", seconds > 0.0 ? tick / seconds : 0.0);
+    printf("ns/agent/tick:    %.2f\n", agentTicks > 0.0 ? seconds * 1e9 / agentTicks : 0.0);
+    printf("Peak droplets:    %d\n", peakDroplets);
+    printf("Alive at end:     %d\n", aliveMosquitoes);
+    printf("Free slots:       %d\n", (int)freeList.size());
+    printf("Brood at end:     %lld eggs and larvae in %d chunks\n", brood.size(), brood.used);
+    const EpidemicTotals& people = epidemic.totals;
+    double households = (double)epidemic.cellCount();
+    printf("Households:       %d x %d\n", epidemic.width, epidemic.height);
+    // Recovered is the remainder, so rounding can leave it a hair below zero
+    double recovered = std::max(0.0, households - people.susceptible - people.exposed - people.infectious);
+    printf("People at end:    %.2f%% susceptible, %.2f%% exposed, %.2f%% infectious, %.2f%% recovered\n",
+        100.0 * people.susceptible / households, 100.0 * people.exposed / households, 100.0 * people.infectious / households,
+        100.0 * recovered / households);
+    printProfilerSummary();
+    return 0;
+}
+
+// Function to print the command line options
+void printUsage(const char* program) {
+    printf("Usage: %s [--headless] [options]\n", program);
+    printf("  --headless        Run the simulation without a window and report timings\n");
+    printf("  --mosquitoes N    Swarm size (default %d)\n", NUM_MOSQUITOES);
+    printf("  --ticks N         Simulation steps in headless mode (default 10000)\n");
+    printf("  --sim-rate HZ     Simulation steps per second (default %d)\n", simulationRate);
+    printf("  --seed N          Random seed (default: current time)\n");
+    printf("  --spray-every N   Start a spray every N ticks in headless mode (default 20)\n");
+    printf("  --spray-at LIST   Also spray at these ticks, e.g. 5,40,300\n");
+    printf("  --no-breeding     Don't lay eggs at the pond and water bowl\n");
+    printf("  --days N          Run headless until N life-cycle days have passed\n");
+    printf("  --fast-forward    Run the life cycle %.0fx faster\n", FAST_FORWARD_FACTOR);
+    printf("  --dry-bowl        Start with the water bowl emptied\n");
+    printf("  --households WxH  Household grid laid over the town (default %dx%d)\n", householdColumns, householdRows);
+    printf("  --infectious F    Share of the starting swarm carrying dengue (default %.2f)\n", infectiousFraction);
+    printf("  --density-above N Draw the swarm as a density map from N mosquitoes (default %d)\n", densityThreshold);
+    printf("  --max-fps N       Draw at most N frames per second (default: no cap)\n");
 }
 
 // Main function
 int main(int argc, char** argv) {
+    bool headless = false;
+    HeadlessConfig config;
+    config.ticks = 10000;
+    config.days = 0.0f;
+    config.sprayEvery = 20;
+    uint64_t seed = static_cast<uint64_t>(time(0));
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+        if (strcmp(arg, "--headless") == 0) {
+            headless = true;
+        } else if (strcmp(arg, "--mosquitoes") == 0 && value) {
+            swarmSize = atoi(value); i++;
+        } else if (strcmp(arg, "--ticks") == 0 && value) {
+            config.ticks = atoi(value); i++;
+        } else if (strcmp(arg, "--sim-rate") == 0 && value) {
+            simulationRate = atoi(value); i++;
+        } else if (strcmp(arg, "--seed") == 0 && value) {
+            seed = strtoull(value, NULL, 10); i++;
+        } else if (strcmp(arg, "--spray-every") == 0 && value) {
+            config.sprayEvery = atoi(value); i++;
+        } else if (strcmp(arg, "--spray-at") == 0 && value) {
+            parseTickList(value, config.sprayAt); i++;
+        } else if (strcmp(arg, "--days") == 0 && value) {
+            config.days = (float)atof(value); i++;
+        } else if (strcmp(arg, "--fast-forward") == 0) {
+            fastForward = true;
+        } else if (strcmp(arg, "--dry-bowl") == 0) {
+            waterBowlVisible = true;
+        } else if (strcmp(arg, "--no-breeding") == 0) {
+            breedingEnabled = false;
+        } else if (strcmp(arg, "--households") == 0 && value) {
+            sscanf(value, "%dx%d", &householdColumns, &householdRows); i++;
+        } else if (strcmp(arg, "--density-above") == 0 && value) {
+            densityThreshold = atoi(value); i++;
+        } else if (strcmp(arg, "--infectious") == 0 && value) {
+            infectiousFraction = (float)atof(value); i++;
+        } else if (strcmp(arg, "--max-fps") == 0 && value) {
+            setFrameCap(atoi(value)); i++;
+        } else if (strcmp(arg, "--help") == 0) {
+            printUsage(argv[0]);
+            return 0;
+        }
+    }
+    if (swarmSize < 1) swarmSize = 1;
+    if (simulationRate < 1) simulationRate = 1;
+    if (householdColumns < 1) householdColumns = 1;
+    if (householdRows < 1) householdRows = 1;
+    seedRandomStreams(seed);
+
+    if (headless) {
+        std::sort(config.sprayAt.begin(), config.sprayAt.end());
+        return runHeadless(config);
+    }
+
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);
     glutInitWindowSize(800, 600);
@@ -366,7 +1447,8 @@ int main(int argc, char** argv) {
     init();
 
     glutDisplayFunc(display);
-    glutTimerFunc(50, timer, 0); // Start timer with 50ms interval
+    glutReshapeFunc(reshape);
+    glutTimerFunc(1000 / renderRate, timer, timerGeneration); // Start the frame timer
     glutKeyboardFunc(keyboard);
 
     glutMainLoop();
@@ -0,0 +1,163 @@
+#ifndef BELTS_H
+#define BELTS_H
+
+#include <cmath>
+#include <vector>
+#include "jobs.h"
+#include "random.h"
+
+// Largest number of particles one belt holds
+const int MAX_BELT_PARTICLES = 1000000;
+
+// Particles per job when placing a belt
+const int BELT_CHUNK_SIZE = 8192;
+
+// Shape of a belt: a ring of orbits between two semi-major axes, with
+// eccentricities up to `maxEccentricity` and inclinations spread over
+// +-`inclinationSpread` radians (denser towards the middle plane)
+struct BeltShape {
+    float inner, outer;
+    float maxEccentricity;
+    float inclinationSpread;
+};
+
+// A belt of massless particles on fixed Kepler orbits around the origin,
+// as a structure of arrays. Eccentricities are small, so the orbits use the
+// first-order expansion of Kepler's equation instead of solving it: that
+// makes every particle the same few multiplies and one sine/cosine pair,
+// with no iteration. Like the bodies, positions are a direct function of
+// time. `vertices` is written x, y, z interleaved so GL draws it as is.
+struct Belt {
+    std::vector<float> distance;     // Semi-major axis
+    std::vector<float> speed;        // Mean motion
+    std::vector<float> phase;        // Mean anomaly at time 0
+    std::vector<float> periapsis;    // Argument of periapsis
+    std::vector<float> eccentricity;
+    std::vector<float> nodeCos, nodeSin;     // Ascending node angle
+    std::vector<float> tiltCos, tiltSin;     // Inclination
+    std::vector<float> vertices;     // x, y, z per particle
+
+    int size() const {
+        return (int)distance.size();
+    }
+};
+
+// Sine and cosine of x for |x| up to about 1e6, without library calls and
+// without branches, so loops calling it vectorize. x is reduced to
+// [-pi, pi], then the half angle goes through short Taylor series and is
+// doubled back; the error is below 1e-5, far under a pixel here.
+inline void beltSinCos(float x, float& s, float& c) {
+    const float inverseTurn = 0.159154943f;
+    const float turn = 6.28318531f;
+    const float roundMagic = 12582912.0f; // 1.5 * 2^23: adding it rounds to a whole number
+    float turns = (x * inverseTurn + roundMagic) - roundMagic;
+    float h = 0.5f * (x - turns * turn); // Half angle in [-pi/2, pi/2]
+    float h2 = h * h;
+    float hs = h * (1.0f + h2 * (-1.0f / 6 + h2 * (1.0f / 120 + h2 * (-1.0f / 5040 + h2 * (1.0f / 362880)))));
+    float hc = 1.0f + h2 * (-0.5f + h2 * (1.0f / 24 + h2 * (-1.0f / 720 + h2 * (1.0f / 40320 + h2 * (-1.0f / 3628800)))));
+    s = 2.0f * hs * hc;
+    c = hc * hc - hs * hs;
+}
+
+// Function to fill a belt with `count` particles; `gm` is the mass of the
+// body at the centre times the gravitational constant, which sets each
+// particle's mean motion from its distance
+inline void generateBelt(Belt& belt, int count, const BeltShape& shape, float gm, Random& random) {
+    if (count > MAX_BELT_PARTICLES) count = MAX_BELT_PARTICLES;
+    if (count < 0) count = 0;
+    belt.distance.resize(count);
+    belt.speed.resize(count);
+    belt.phase.resize(count);
+    belt.periapsis.resize(count);
+    belt.eccentricity.resize(count);
+    belt.nodeCos.resize(count);
+    belt.nodeSin.resize(count);
+    belt.tiltCos.resize(count);
+    belt.tiltSin.resize(count);
+    belt.vertices.assign(count * 3, 0.0f);
+
+    const float turn = 6.28318531f;
+    for (int i = 0; i < count; i++) {
+        // Two uniforms averaged thin the edges of the ring out
+        float a = shape.inner + (shape.outer - shape.inner) * 0.5f * (random.nextFloat() + random.nextFloat());
+        float node = random.range(0.0f, turn);
+        float tilt = shape.inclinationSpread * (random.nextFloat() + random.nextFloat() - 1.0f);
+        belt.distance[i] = a;
+        belt.speed[i] = sqrtf(gm / (a * a * a));
+        belt.phase[i] = random.range(0.0f, turn);
+        belt.periapsis[i] = random.range(0.0f, turn);
+        belt.eccentricity[i] = shape.maxEccentricity * random.nextFloat();
+        belt.nodeCos[i] = cosf(node);
+        belt.nodeSin[i] = sinf(node);
+        belt.tiltCos[i] = cosf(tilt);
+        belt.tiltSin[i] = sinf(tilt);
+    }
+}
+
+// Reduces a mean anomaly to [-pi, pi] in double, so precision doesn't fade
+// as time grows, then hands it on as a float
+inline float beltMeanAnomaly(float phase, float speed, double time) {
+    const double inverseTurn = 0.15915494309189535;
+    const double turn = 6.283185307179586;
+    const double roundMagic = 6755399441055744.0; // 1.5 * 2^52: adding it rounds to a whole number
+    double whole = phase + speed * time;
+    return (float)(whole - turn * ((whole * inverseTurn + roundMagic) - roundMagic));
+}
+
+// Function to place particle i of a belt at `time` into x, y, z
+inline void beltPosition(const Belt& belt, int i, double time, float& x, float& y, float& z) {
+    float mean = beltMeanAnomaly(belt.phase[i], belt.speed[i], time);
+
+    // First order in e: r = a (1 - e cos M), true anomaly = M + 2e sin M
+    float sm, cm;
+    beltSinCos(mean, sm, cm);
+    float e = belt.eccentricity[i];
+    float r = belt.distance[i] * (1.0f - e * cm);
+    float su, cu;
+    beltSinCos(mean + 2.0f * e * sm + belt.periapsis[i], su, cu);
+
+    // In the orbit plane, tilted about the node line, turned to the node
+    float along = r * cu;
+    float across = r * su;
+    float flat = across * belt.tiltCos[i];
+    x = along * belt.nodeCos[i] - flat * belt.nodeSin[i];
+    y = across * belt.tiltSin[i];
+    z = along * belt.nodeSin[i] + flat * belt.nodeCos[i];
+}
+
+// Function to place particles [begin, end) of a belt at `time`. Particles
+// go through in blocks of eight with no branches, worked out into local
+// arrays before being stored, so the compiler runs a whole block in vector
+// registers. A short last block is redone as the final eight particles;
+// placing a particle twice gives the same result.
+inline void placeBeltParticles(Belt& belt, int begin, int end, double time) {
+    float* out = belt.vertices.data();
+    if (end - begin < 8) {
+        for (int i = begin; i < end; i++) {
+            beltPosition(belt, i, time, out[i * 3], out[i * 3 + 1], out[i * 3 + 2]);
+        }
+        return;
+    }
+    for (int i = begin; i < end; i += 8) {
+        if (i + 8 > end) i = end - 8;
+        float x[8], y[8], z[8];
+        for (int l = 0; l < 8; l++) {
+            beltPosition(belt, i + l, time, x[l], y[l], z[l]);
+        }
+        for (int l = 0; l < 8; l++) {
+            out[(i + l) * 3] = x[l];
+            out[(i + l) * 3 + 1] = y[l];
+            out[(i + l) * 3 + 2] = z[l];
+        }
+    }
+}
+
+// Function to place every particle of a belt at `time`, in parallel chunks
+inline void placeBelt(Belt& belt, double time, JobSystem& jobs) {
+    Belt* target = &belt;
+    jobs.parallelFor(belt.size(), BELT_CHUNK_SIZE, [=](int begin, int end) {
+        placeBeltParticles(*target, begin, end, time);
+    });
+}
+
+#endif
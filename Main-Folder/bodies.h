@@ -0,0 +1,193 @@
+#ifndef BODIES_H
+#define BODIES_H
+
+#include <cmath>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Body names stored once each; bodies refer to them by id
+struct NameTable {
+    std::vector<char> chars;  // Every distinct name, each followed by '\0'
+    std::vector<int> offsets; // Start of each name in chars
+    std::unordered_map<std::string, int> ids;
+
+    // Returns the id of a name, adding it on first use
+    int intern(const std::string& name) {
+        std::unordered_map<std::string, int>::const_iterator found = ids.find(name);
+        if (found != ids.end()) {
+            return found->second;
+        }
+        int id = (int)offsets.size();
+        offsets.push_back((int)chars.size());
+        chars.insert(chars.end(), name.begin(), name.end());
+        chars.push_back('\0');
+        ids[name] = id;
+        return id;
+    }
+
+    const char* name(int id) const {
+        return &chars[offsets[id]];
+    }
+
+    void clear() {
+        chars.clear();
+        offsets.clear();
+        ids.clear();
+    }
+};
+
+// Number of Newton steps when solving Kepler's equation. From the starting
+// guess below this reaches float precision for any eccentricity under 0.9.
+const int KEPLER_ITERATIONS = 5;
+
+// Orbiting bodies as a structure of arrays, one index per body.
+// Each body follows a Keplerian ellipse around its parent, described by
+// fixed orbital elements, so its position is a direct function of time:
+// any time costs the same to evaluate, however far it is from the last.
+// A parent is always added before its children, so one forward sweep over
+// the arrays places every body after its parent has been placed.
+struct BodyTable {
+    std::vector<int> parent;       // Index of the body orbited, -1 for the root
+    std::vector<int> name;         // Id in `names`
+    std::vector<float> radius;
+    std::vector<float> distance;   // Semi-major axis of the orbit around the parent
+    std::vector<float> eccentricity;
+    std::vector<double> speed;     // Mean motion: mean anomaly gained per unit of time
+    std::vector<double> phase;     // Mean anomaly at time 0
+    std::vector<float> px, py, pz; // Unit vector towards periapsis
+    std::vector<float> qx, qy, qz; // Unit vector 90 degrees ahead of it in the orbit plane
+    std::vector<float> mean;       // Mean anomaly at the last update, in [-pi, pi]
+    std::vector<float> anomaly;    // Eccentric anomaly at the last update
+    std::vector<float> r, g, b;
+    std::vector<float> x, y, z;    // World position, refreshed by updatePositions()
+    NameTable names;
+
+    int size() const {
+        return (int)parent.size();
+    }
+
+    void clear() {
+        parent.clear();
+        name.clear();
+        radius.clear();
+        distance.clear();
+        eccentricity.clear();
+        speed.clear();
+        phase.clear();
+        px.clear(); py.clear(); pz.clear();
+        qx.clear(); qy.clear(); qz.clear();
+        mean.clear();
+        anomaly.clear();
+        r.clear();
+        g.clear();
+        b.clear();
+        x.clear();
+        y.clear();
+        z.clear();
+        names.clear();
+    }
+
+    // Appends a body on a circular orbit in the XZ plane and returns its
+    // index; `parentId` must already exist
+    int add(const std::string& bodyName, int parentId, float bodyRadius, float orbitRadius, float orbitSpeed,
+        float red, float green, float blue) {
+        parent.push_back(parentId);
+        name.push_back(names.intern(bodyName));
+        radius.push_back(bodyRadius);
+        distance.push_back(orbitRadius);
+        eccentricity.push_back(0.0f);
+        speed.push_back(orbitSpeed);
+        phase.push_back(0.0);
+        px.push_back(1.0f); py.push_back(0.0f); pz.push_back(0.0f);
+        qx.push_back(0.0f); qy.push_back(0.0f); qz.push_back(1.0f);
+        mean.push_back(0.0f);
+        anomaly.push_back(0.0f);
+        r.push_back(red);
+        g.push_back(green);
+        b.push_back(blue);
+        x.push_back(0.0f);
+        y.push_back(0.0f);
+        z.push_back(0.0f);
+        return size() - 1;
+    }
+
+    // Gives a body's orbit its shape and orientation, angles in radians:
+    // the orbit is tilted by `inclination` about the line of nodes, which
+    // lies at `node` from the X axis, and periapsis sits `periapsis` along
+    // the orbit from the ascending node. Y is the reference plane's normal.
+    void shapeOrbit(int body, float orbitEccentricity, float inclination, float node, float periapsis) {
+        eccentricity[body] = orbitEccentricity;
+        float cw = cosf(periapsis), sw = sinf(periapsis);
+        float ci = cosf(inclination), si = sinf(inclination);
+        float cn = cosf(node), sn = sinf(node);
+        // Rotate by the periapsis angle in the plane, tilt about X, then
+        // turn the tilted plane to the node; angles run from X towards Z
+        px[body] = cn * cw - sn * ci * sw;
+        py[body] = si * sw;
+        pz[body] = sn * cw + cn * ci * sw;
+        qx[body] = -cn * sw - sn * ci * cw;
+        qy[body] = si * cw;
+        qz[body] = -sn * sw + cn * ci * cw;
+    }
+
+    const char* nameOf(int body) const {
+        return names.name(name[body]);
+    }
+
+    // Solves Kepler's equation M = E - e sin E for every body at `time`.
+    // Mean anomalies are reduced to one turn in double precision so long
+    // runs and large seeks lose nothing. All bodies take the same fixed
+    // number of Newton steps with no branches, so the loop vectorizes
+    // where the compiler has vector sine and cosine.
+    void solveKepler(double time) {
+        const double turn = 6.283185307179586;
+        const int n = size();
+        float* m = mean.data();
+        float* solved = anomaly.data();
+        const float* e = eccentricity.data();
+        for (int i = 0; i < n; i++) {
+            double whole = phase[i] + speed[i] * time;
+            whole -= turn * floor(whole / turn);
+            m[i] = (float)(whole > 3.141592653589793 ? whole - turn : whole);
+            solved[i] = m[i] + 0.85f * e[i] * copysignf(1.0f, m[i]);
+        }
+        for (int k = 0; k < KEPLER_ITERATIONS; k++) {
+            for (int i = 0; i < n; i++) {
+                float ea = solved[i];
+                solved[i] = ea - (ea - e[i] * sinf(ea) - m[i]) / (1.0f - e[i] * cosf(ea));
+            }
+        }
+    }
+
+    // Places every body at `time` relative to its already placed parent
+    void updatePositions(double time) {
+        solveKepler(time);
+        for (int i = 0, n = size(); i < n; i++) {
+            int p = parent[i];
+            if (p < 0) {
+                x[i] = y[i] = z[i] = 0.0f;
+                continue;
+            }
+            float e = eccentricity[i];
+            float along = distance[i] * (cosf(anomaly[i]) - e);
+            float across = distance[i] * sqrtf(1.0f - e * e) * sinf(anomaly[i]);
+            x[i] = x[p] + along * px[i] + across * qx[i];
+            y[i] = y[p] + along * py[i] + across * qy[i];
+            z[i] = z[p] + along * pz[i] + across * qz[i];
+        }
+    }
+
+    // Velocity of a body relative to its parent at the last update
+    void orbitVelocity(int body, float& vx, float& vy, float& vz) const {
+        float e = eccentricity[body];
+        float rate = (float)speed[body] / (1.0f - e * cosf(anomaly[body])); // dE/dt
+        float along = -distance[body] * sinf(anomaly[body]) * rate;
+        float across = distance[body] * sqrtf(1.0f - e * e) * cosf(anomaly[body]) * rate;
+        vx = along * px[body] + across * qx[body];
+        vy = along * py[body] + across * qy[body];
+        vz = along * pz[body] + across * qz[body];
+    }
+};
+
+#endif
@@ -0,0 +1,241 @@
+#ifndef EPIDEMIC_H
+#define EPIDEMIC_H
+
+#include <algorithm>
+#include <vector>
+#include "jobs.h"
+
+// Dengue in people, modelled per household as SEIR fractions:
+// susceptible, exposed (incubating), infectious and recovered. Infectious
+// bites from the swarm seed it; the unmodelled local mosquitoes around each
+// house carry it on to the household itself and its four neighbours.
+const float HOUSEHOLD_SIZE = 5.0f;         // People per household; one bite exposes one person
+const float LOCAL_INFECTION_RATE = 0.35f;  // Infections per person-day from a fully infectious household
+const float NEIGHBOUR_SHARE = 0.4f;        // Part of that pressure falling on the four adjacent households
+const float INCUBATION_RATE = 1.0f / 5.5f; // Exposed people becoming infectious per day
+const float RECOVERY_RATE = 1.0f / 7.0f;   // Infectious people recovering per day
+const float MOSQUITO_ACQUIRE = 0.5f;       // Chance a bite on an infectious person infects the mosquito
+const float BITES_PER_DAY = 0.5f;          // Bites a mosquito takes per day
+const float EPIDEMIC_FLOOR = 1e-9f;        // Smaller fractions are cleared: far below one person, and
+                                           // left alone they shrink into denormals that stall the stencil
+
+// Cache blocking for the stencil: each job owns a band of rows, and wide
+// rows are walked in column tiles so the three infectious rows a tile reads
+// stay in cache while every row of the band passes over them
+const int EPIDEMIC_BAND_ROWS = 16;
+const int EPIDEMIC_TILE_COLUMNS = 2048;
+
+// Sums of the household fractions over the grid
+struct EpidemicTotals {
+    double susceptible, exposed, infectious;
+
+    EpidemicTotals() : susceptible(0.0), exposed(0.0), infectious(0.0) {}
+
+    EpidemicTotals& operator+=(const EpidemicTotals& other) {
+        susceptible += other.susceptible;
+        exposed += other.exposed;
+        infectious += other.infectious;
+        return *this;
+    }
+};
+
+// Per-step rates shared by every household, already scaled by the step length
+struct EpidemicRates {
+    float local;     // Infection pressure from the household itself
+    float neighbour; // Infection pressure from each of its four neighbours
+    float incubate;  // Share of exposed people becoming infectious
+    float recover;   // Share of infectious people recovering
+};
+
+// A rectangle of households laid over the scene, stored as a structure of
+// arrays. Susceptible and exposed only change from their own cell, so they
+// are updated in place; infectious is double-buffered because the stencil
+// reads the neighbours' values from the previous step. Recovered is
+// whatever remains of each household.
+struct EpidemicGrid {
+    int width, height;
+    float minX, minY;
+    float inverseCellWidth, inverseCellHeight;
+    std::vector<float> susceptible;
+    std::vector<float> exposed;
+    std::vector<float> infectious[2];
+    int front; // Buffer holding the latest infectious fractions
+    EpidemicTotals totals; // From the latest step
+
+    EpidemicGrid() : width(0), height(0), minX(0.0f), minY(0.0f), inverseCellWidth(1.0f), inverseCellHeight(1.0f), front(0) {}
+
+    // Function to lay a w x h grid of households over a rectangle
+    void configure(int w, int h, float x0, float y0, float x1, float y1) {
+        width = w;
+        height = h;
+        minX = x0;
+        minY = y0;
+        inverseCellWidth = w / (x1 - x0);
+        inverseCellHeight = h / (y1 - y0);
+        size_t cells = (size_t)w * h;
+        susceptible.resize(cells);
+        exposed.resize(cells);
+        infectious[0].resize(cells);
+        infectious[1].resize(cells);
+        clear();
+    }
+
+    // Function to make everyone susceptible again
+    void clear() {
+        std::fill(susceptible.begin(), susceptible.end(), 1.0f);
+        std::fill(exposed.begin(), exposed.end(), 0.0f);
+        std::fill(infectious[0].begin(), infectious[0].end(), 0.0f);
+        std::fill(infectious[1].begin(), infectious[1].end(), 0.0f);
+        front = 0;
+        totals = EpidemicTotals();
+        totals.susceptible = (double)width * height;
+    }
+
+    long long cellCount() const {
+        return (long long)width * height;
+    }
+
+    // Function to find the household under (x, y); points outside the grid
+    // land in the nearest edge household
+    size_t cellAt(float x, float y) const {
+        int c = (int)((x - minX) * inverseCellWidth);
+        int r = (int)((y - minY) * inverseCellHeight);
+        c = c < 0 ? 0 : (c >= width ? width - 1 : c);
+        r = r < 0 ? 0 : (r >= height ? height - 1 : r);
+        return (size_t)r * width + c;
+    }
+
+    // Function to get the latest infectious fraction of a household
+    float infectiousAt(size_t cell) const {
+        return infectious[front][cell];
+    }
+
+    // Function to expose one susceptible person in a household to the virus
+    void expose(size_t cell) {
+        float dose = std::min(susceptible[cell], 1.0f / HOUSEHOLD_SIZE);
+        susceptible[cell] -= dose;
+        exposed[cell] += dose;
+    }
+};
+
+// Function to scale the daily rates to a step of `days`
+inline EpidemicRates epidemicRates(float days) {
+    EpidemicRates rates;
+    rates.local = LOCAL_INFECTION_RATE * (1.0f - NEIGHBOUR_SHARE) * days;
+    rates.neighbour = LOCAL_INFECTION_RATE * NEIGHBOUR_SHARE * 0.25f * days;
+    rates.incubate = std::min(INCUBATION_RATE * days, 1.0f);
+    rates.recover = std::min(RECOVERY_RATE * days, 1.0f);
+    return rates;
+}
+
+// Function to advance one household given the sum of its neighbours'
+// infectious fractions; writes the new infectious fraction to `next`
+inline void advanceHousehold(float& s, float& e, float i, float neighbours, float& next, const EpidemicRates& rates) {
+    float infected = s * std::min(rates.local * i + rates.neighbour * neighbours, 1.0f);
+    float onset = e * rates.incubate;
+    float susceptible = s - infected;
+    float exposed = e + infected - onset;
+    float infectious = i + onset - i * rates.recover;
+    s = susceptible > EPIDEMIC_FLOOR ? susceptible : 0.0f;
+    e = exposed > EPIDEMIC_FLOOR ? exposed : 0.0f;
+    next = infectious > EPIDEMIC_FLOOR ? infectious : 0.0f;
+}
+
+// Function to sum a span of floats in eight independent lanes, so the
+// compiler can keep the additions in vector registers
+inline float sumSpan(const float* values, int count) {
+    float lanes[8] = {};
+    int c = 0;
+    for (; c + 8 <= count; c += 8) {
+        for (int l = 0; l < 8; l++) {
+            lanes[l] += values[c + l];
+        }
+    }
+    float total = 0.0f;
+    for (; c < count; c++) {
+        total += values[c];
+    }
+    for (int l = 0; l < 8; l++) {
+        total += lanes[l];
+    }
+    return total;
+}
+
+// Function to advance rows [rowBegin, rowEnd) of the grid. Reads infectious
+// fractions from the front buffer and writes them to the back one. Edge
+// households treat their missing neighbours as copies of themselves. The
+// interior loop has no branches so it vectorizes.
+inline EpidemicTotals stepEpidemicRows(EpidemicGrid& grid, int rowBegin, int rowEnd, const EpidemicRates& rates) {
+    EpidemicTotals totals;
+    const int w = grid.width;
+    const float* in = grid.infectious[grid.front].data();
+    float* out = grid.infectious[1 - grid.front].data();
+    for (int c0 = 0; c0 < w; c0 += EPIDEMIC_TILE_COLUMNS) {
+        int c1 = std::min(c0 + EPIDEMIC_TILE_COLUMNS, w);
+        for (int r = rowBegin; r < rowEnd; r++) {
+            size_t row = (size_t)r * w;
+            const float* mid = in + row;
+            const float* up = r > 0 ? mid - w : mid;
+            const float* down = r < grid.height - 1 ? mid + w : mid;
+            float* s = grid.susceptible.data() + row;
+            float* e = grid.exposed.data() + row;
+            float* next = out + row;
+
+            int first = std::max(c0, 1);
+            int last = std::min(c1, w - 1);
+            if (c0 == 0) {
+                int right = w > 1 ? 1 : 0;
+                advanceHousehold(s[0], e[0], mid[0], up[0] + down[0] + mid[0] + mid[right], next[0], rates);
+            }
+            for (int c = first; c < last; c++) {
+                advanceHousehold(s[c], e[c], mid[c], up[c] + down[c] + mid[c - 1] + mid[c + 1], next[c], rates);
+            }
+            if (c1 == w && w > 1) {
+                int c = w - 1;
+                advanceHousehold(s[c], e[c], mid[c], up[c] + down[c] + mid[c - 1] + mid[c], next[c], rates);
+            }
+
+            totals.susceptible += sumSpan(s + c0, c1 - c0);
+            totals.exposed += sumSpan(e + c0, c1 - c0);
+            totals.infectious += sumSpan(next + c0, c1 - c0);
+        }
+    }
+    return totals;
+}
+
+// Function to advance every household by `days`, one band of rows per job,
+// then make the newly written infectious buffer the front one. Totals are
+// folded in band order, so they don't depend on the thread count.
+inline void stepEpidemic(EpidemicGrid& grid, float days, JobSystem& jobs) {
+    EpidemicGrid* target = &grid;
+    EpidemicRates rates = epidemicRates(days);
+    grid.totals = jobs.parallelReduce(grid.height, EPIDEMIC_BAND_ROWS, EpidemicTotals(),
+        [=](int begin, int end) { return stepEpidemicRows(*target, begin, end, rates); },
+        [](EpidemicTotals a, const EpidemicTotals& b) { return a += b; });
+    grid.front = 1 - grid.front;
+}
+
+// Function to average the infectious fraction of the households under each
+// cell of an outW x outH image, one job per band of image rows
+inline void sampleInfectious(const EpidemicGrid& grid, float* out, int outW, int outH, JobSystem& jobs) {
+    const EpidemicGrid* source = &grid;
+    jobs.parallelFor(outH, 8, [=](int begin, int end) {
+        const float* in = source->infectious[source->front].data();
+        const int w = source->width, h = source->height;
+        for (int ty = begin; ty < end; ty++) {
+            int r0 = (int)((long long)ty * h / outH);
+            int r1 = std::max(r0 + 1, (int)((long long)(ty + 1) * h / outH));
+            for (int tx = 0; tx < outW; tx++) {
+                int c0 = (int)((long long)tx * w / outW);
+                int c1 = std::max(c0 + 1, (int)((long long)(tx + 1) * w / outW));
+                float sum = 0.0f;
+                for (int r = r0; r < r1; r++) {
+                    sum += sumSpan(in + (size_t)r * w + c0, c1 - c0);
+                }
+                out[ty * outW + tx] = sum / ((r1 - r0) * (c1 - c0));
+            }
+        }
+    });
+}
+
+#endif
@@ -0,0 +1,288 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include <GL/glut.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// Largest segment count a unit circle table can be built for
+const int MAX_CIRCLE_SEGMENTS = 1024;
+
+// Unit circle sampled at evenly spaced angles.
+// Holds segments + 1 entries; the last one repeats the first so closed
+// fans can walk 0..segments inclusive without wrapping.
+struct CircleTable {
+    int segments;
+    std::vector<float> c; // cos(angle)
+    std::vector<float> s; // sin(angle)
+
+    explicit CircleTable(int n) : segments(n), c(n + 1), s(n + 1) {
+        for (int i = 0; i < n; i++) {
+            double angle = 2.0 * 3.14159265358979323846 * i / n;
+            c[i] = (float)cos(angle);
+            s[i] = (float)sin(angle);
+        }
+        c[n] = c[0];
+        s[n] = s[0];
+    }
+};
+
+// Returns the shared table for a segment count, building it on first use.
+// Tables live for the whole program; call from the GL thread only.
+inline const CircleTable& unitCircle(int segments) {
+    static CircleTable* tables[MAX_CIRCLE_SEGMENTS + 1] = {};
+    if (segments < 3) segments = 3;
+    if (segments > MAX_CIRCLE_SEGMENTS) segments = MAX_CIRCLE_SEGMENTS;
+    if (!tables[segments]) {
+        tables[segments] = new CircleTable(segments);
+    }
+    return *tables[segments];
+}
+
+// Builds the tables for the segment counts the programs draw with every frame
+inline void warmCircleTables(const int* counts, int n) {
+    for (int i = 0; i < n; i++) {
+        unitCircle(counts[i]);
+    }
+}
+
+// Emits the rim of an ellipse centred at (cx, cy) in the XY plane.
+// Call between glBegin/glEnd; `closed` repeats the first vertex at the end.
+inline void emitEllipse2D(const CircleTable& t, float cx, float cy, float rx, float ry, bool closed) {
+    int n = closed ? t.segments + 1 : t.segments;
+    for (int i = 0; i < n; i++) {
+        glVertex2f(cx + rx * t.c[i], cy + ry * t.s[i]);
+    }
+}
+
+// Draws a filled disc as a triangle fan around (cx, cy)
+inline void drawDisc2D(const CircleTable& t, float cx, float cy, float r) {
+    glBegin(GL_TRIANGLE_FAN);
+    glVertex2f(cx, cy);
+    emitEllipse2D(t, cx, cy, r, r, true);
+    glEnd();
+}
+
+// Segment counts the baked rings come in, and the on-screen length in
+// pixels each segment of a ring should cover at most
+const int RING_LEVELS = 6;
+const int RING_SEGMENTS[RING_LEVELS] = { 16, 32, 64, 128, 256, 512 };
+const float RING_PIXELS_PER_SEGMENT = 8.0f;
+
+// Returns the display list of a closed unit circle in the XZ plane with the
+// segment count of `level`, building every level on first use. Scale it
+// with glScalef; needs a current GL context.
+inline GLuint unitRingList(int level) {
+    static GLuint lists = 0;
+    if (lists == 0) {
+        lists = glGenLists(RING_LEVELS);
+        for (int l = 0; l < RING_LEVELS; l++) {
+            const CircleTable& unit = unitCircle(RING_SEGMENTS[l]);
+            glNewList(lists + l, GL_COMPILE);
+            glBegin(GL_LINE_LOOP);
+            for (int i = 0; i < unit.segments; i++) {
+                glVertex3f(unit.c[i], 0.0f, unit.s[i]);
+            }
+            glEnd();
+            glEndList();
+        }
+    }
+    if (level < 0) level = 0;
+    if (level >= RING_LEVELS) level = RING_LEVELS - 1;
+    return lists + level;
+}
+
+// Picks the ring level for a circle whose radius covers `pixels` on screen
+inline int ringLevelForPixels(float pixels) {
+    float needed = 2.0f * 3.14159265f * pixels / RING_PIXELS_PER_SEGMENT;
+    int level = 0;
+    while (level + 1 < RING_LEVELS && RING_SEGMENTS[level] < needed) {
+        level++;
+    }
+    return level;
+}
+
+// Sphere tessellation levels, coarsest first, and the projected radius in
+// pixels from which each level is used
+const int SPHERE_LEVELS = 5;
+const int SPHERE_SLICES[SPHERE_LEVELS] = { 8, 12, 18, 28, 40 };
+const int SPHERE_STACKS[SPHERE_LEVELS] = { 5, 8, 12, 18, 26 };
+const float SPHERE_LEVEL_PIXELS[SPHERE_LEVELS] = { 0.0f, 6.0f, 15.0f, 40.0f, 100.0f };
+
+// A unit sphere recorded once into display lists, solid and wireframe.
+// Positions double as normals; scale with glScalef and keep GL_NORMALIZE on.
+struct SphereMesh {
+    int slices, stacks;
+    GLuint solidList;
+    GLuint wireList;
+};
+
+// Builds both display lists for a unit sphere with the given tessellation;
+// the poles lie on the y axis
+inline void buildSphereMesh(SphereMesh& mesh, int slices, int stacks) {
+    mesh.slices = slices;
+    mesh.stacks = stacks;
+    const CircleTable& ring = unitCircle(slices);
+    std::vector<float> vertices;
+    vertices.reserve((stacks + 1) * (slices + 1) * 3);
+    for (int i = 0; i <= stacks; i++) {
+        double theta = 3.14159265358979323846 * i / stacks;
+        float y = (float)cos(theta);
+        float r = (float)sin(theta);
+        for (int j = 0; j <= slices; j++) {
+            vertices.push_back(r * ring.c[j]);
+            vertices.push_back(y);
+            vertices.push_back(-r * ring.s[j]);
+        }
+    }
+
+    // Two counter-clockwise triangles per quad between neighbouring rings
+    std::vector<GLushort> triangles;
+    triangles.reserve(stacks * slices * 6);
+    for (int i = 0; i < stacks; i++) {
+        for (int j = 0; j < slices; j++) {
+            GLushort a = (GLushort)(i * (slices + 1) + j);
+            GLushort b = (GLushort)(a + slices + 1);
+            triangles.push_back(a);
+            triangles.push_back(b);
+            triangles.push_back((GLushort)(b + 1));
+            triangles.push_back(a);
+            triangles.push_back((GLushort)(b + 1));
+            triangles.push_back((GLushort)(a + 1));
+        }
+    }
+
+    // Meridians, then the rings between the poles
+    std::vector<GLushort> lines;
+    for (int j = 0; j < slices; j++) {
+        for (int i = 0; i < stacks; i++) {
+            lines.push_back((GLushort)(i * (slices + 1) + j));
+            lines.push_back((GLushort)((i + 1) * (slices + 1) + j));
+        }
+    }
+    for (int i = 1; i < stacks; i++) {
+        for (int j = 0; j < slices; j++) {
+            lines.push_back((GLushort)(i * (slices + 1) + j));
+            lines.push_back((GLushort)(i * (slices + 1) + j + 1));
+        }
+    }
+
+    mesh.solidList = glGenLists(2);
+    mesh.wireList = mesh.solidList + 1;
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, vertices.data());
+    glNewList(mesh.solidList, GL_COMPILE);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glNormalPointer(GL_FLOAT, 0, vertices.data());
+    glDrawElements(GL_TRIANGLES, (GLsizei)triangles.size(), GL_UNSIGNED_SHORT, triangles.data());
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glEndList();
+    glNewList(mesh.wireList, GL_COMPILE);
+    glDrawElements(GL_LINES, (GLsizei)lines.size(), GL_UNSIGNED_SHORT, lines.data());
+    glEndList();
+    glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+// Returns the shared sphere mesh for a level, building every level on
+// first use. Needs a current GL context; call from the GL thread only.
+inline const SphereMesh& sphereMesh(int level) {
+    static SphereMesh meshes[SPHERE_LEVELS];
+    static bool built = false;
+    if (!built) {
+        for (int l = 0; l < SPHERE_LEVELS; l++) {
+            buildSphereMesh(meshes[l], SPHERE_SLICES[l], SPHERE_STACKS[l]);
+        }
+        built = true;
+    }
+    if (level < 0) level = 0;
+    if (level >= SPHERE_LEVELS) level = SPHERE_LEVELS - 1;
+    return meshes[level];
+}
+
+// Picks the tessellation level for a sphere covering `pixels` on screen
+inline int sphereLevelForPixels(float pixels) {
+    int level = 0;
+    while (level + 1 < SPHERE_LEVELS && pixels >= SPHERE_LEVEL_PIXELS[level + 1]) {
+        level++;
+    }
+    return level;
+}
+
+// Draws a sphere of `radius` at the current origin from the cached meshes
+inline void drawSphere(float radius, int level, bool wire = false) {
+    const SphereMesh& mesh = sphereMesh(level);
+    glPushMatrix();
+    glScalef(radius, radius, radius);
+    glCallList(wire ? mesh.wireList : mesh.solidList);
+    glPopMatrix();
+}
+
+// The six planes bounding what the camera sees: left, right, bottom, top,
+// near, far. Normals point inwards and are unit length, so a plane's value
+// at a point is its signed distance. Stored one array per coefficient so a
+// test over many spheres runs the same arithmetic across all of them.
+struct Frustum {
+    float nx[6], ny[6], nz[6], d[6];
+};
+
+// Extracts the planes from the projection and modelview matrices
+// (column-major, as glGetFloatv returns them); the planes are in the space
+// the modelview matrix maps from
+inline void extractFrustum(Frustum& f, const float projection[16], const float modelview[16]) {
+    float clip[16]; // projection * modelview
+    for (int col = 0; col < 4; col++) {
+        for (int row = 0; row < 4; row++) {
+            clip[col * 4 + row] = projection[row] * modelview[col * 4] + projection[4 + row] * modelview[col * 4 + 1]
+                + projection[8 + row] * modelview[col * 4 + 2] + projection[12 + row] * modelview[col * 4 + 3];
+        }
+    }
+    // Each plane is the w row plus or minus the x, y or z row
+    for (int p = 0; p < 6; p++) {
+        int row = p / 2;
+        float sign = (p % 2 == 0) ? 1.0f : -1.0f;
+        float a = clip[3] + sign * clip[row];
+        float b = clip[7] + sign * clip[4 + row];
+        float c = clip[11] + sign * clip[8 + row];
+        float d = clip[15] + sign * clip[12 + row];
+        float length = sqrt(a * a + b * b + c * c);
+        f.nx[p] = a / length;
+        f.ny[p] = b / length;
+        f.nz[p] = c / length;
+        f.d[p] = d / length;
+    }
+}
+
+// Signed distance from the frustum to the nearest point of a sphere: the
+// smallest of its six plane distances, less the radius. Negative means the
+// sphere is wholly outside.
+inline float frustumDistance(const Frustum& f, float x, float y, float z, float radius) {
+    float nearest = f.nx[0] * x + f.ny[0] * y + f.nz[0] * z + f.d[0];
+    for (int p = 1; p < 6; p++) {
+        nearest = std::min(nearest, f.nx[p] * x + f.ny[p] * y + f.nz[p] * z + f.d[p]);
+    }
+    return nearest + radius;
+}
+
+// Marks which of `count` bounding spheres reach into the frustum: visible[i]
+// becomes 1 or 0. Spheres go through in blocks of eight with no branches,
+// so the compiler keeps a block in vector registers and tests all eight
+// against each plane at once.
+inline void cullSpheres(const Frustum& f, const float* x, const float* y, const float* z, const float* radius,
+    int count, unsigned char* visible) {
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        float distance[8];
+        for (int l = 0; l < 8; l++) {
+            distance[l] = frustumDistance(f, x[i + l], y[i + l], z[i + l], radius[i + l]);
+        }
+        for (int l = 0; l < 8; l++) {
+            visible[i + l] = distance[l] >= 0.0f;
+        }
+    }
+    for (; i < count; i++) {
+        visible[i] = frustumDistance(f, x[i], y[i], z[i], radius[i]) >= 0.0f;
+    }
+}
+
+#endif
@@ -0,0 +1,122 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include <algorithm>
+#include <vector>
+
+// Uniform grid over a rectangle for fixed-radius point queries.
+// build() counting-sorts the points by cell and keeps a copy of their
+// positions in cell order, so a query walks contiguous memory. Points
+// outside the rectangle land in the nearest edge cell. Storage only grows,
+// so rebuilding every step doesn't allocate once the point count settles.
+struct PointGrid {
+    float minX, minY;
+    float cellSize;
+    float inverseCellSize;
+    int cols, rows;
+    std::vector<int> cellStart;  // cols * rows + 1 offsets into the arrays below
+    std::vector<int> items;      // Point indices in cell order
+    std::vector<float> sortedX;  // Point positions in cell order
+    std::vector<float> sortedY;
+    std::vector<int> pointCell;  // Cell of each input point (scratch)
+
+    PointGrid() : minX(-1.0f), minY(-1.0f), cellSize(1.0f), inverseCellSize(1.0f), cols(1), rows(1) {}
+
+    // Function to set the covered rectangle and cell size
+    void configure(float x0, float y0, float x1, float y1, float size) {
+        minX = x0;
+        minY = y0;
+        cellSize = size;
+        inverseCellSize = 1.0f / size;
+        cols = (int)((x1 - x0) * inverseCellSize) + 1;
+        rows = (int)((y1 - y0) * inverseCellSize) + 1;
+        cellStart.assign(cols * rows + 1, 0);
+    }
+
+    int column(float x) const {
+        int c = (int)((x - minX) * inverseCellSize);
+        return c < 0 ? 0 : (c >= cols ? cols - 1 : c);
+    }
+
+    int row(float y) const {
+        int r = (int)((y - minY) * inverseCellSize);
+        return r < 0 ? 0 : (r >= rows ? rows - 1 : r);
+    }
+
+    // Function to sort `count` points into the grid. Point i is read from
+    // x[i * stride] and y[i * stride]; `ids`, when given, maps it to the
+    // index reported back by queries.
+    void build(const float* x, const float* y, int count, int stride = 1, const int* ids = 0) {
+        int cells = cols * rows;
+        std::fill(cellStart.begin(), cellStart.end(), 0);
+        pointCell.resize(count);
+        items.resize(count);
+        sortedX.resize(count);
+        sortedY.resize(count);
+
+        for (int i = 0; i < count; i++) {
+            int cell = row(y[i * stride]) * cols + column(x[i * stride]);
+            pointCell[i] = cell;
+            cellStart[cell + 1]++;
+        }
+        for (int c = 0; c < cells; c++) {
+            cellStart[c + 1] += cellStart[c];
+        }
+        // Scatter, using the next cell's start as a running cursor
+        for (int i = 0; i < count; i++) {
+            int slot = cellStart[pointCell[i]]++;
+            items[slot] = ids ? ids[i] : i;
+            sortedX[slot] = x[i * stride];
+            sortedY[slot] = y[i * stride];
+        }
+        // The scatter advanced every start to its end; shift back
+        for (int c = cells; c > 0; c--) {
+            cellStart[c] = cellStart[c - 1];
+        }
+        cellStart[0] = 0;
+    }
+
+    // Function to check whether any point lies within `radius` of (x, y)
+    bool anyWithin(float x, float y, float radius) const {
+        float r2 = radius * radius;
+        int c0 = column(x - radius), c1 = column(x + radius);
+        int r0 = row(y - radius), r1 = row(y + radius);
+        for (int r = r0; r <= r1; r++) {
+            for (int c = c0; c <= c1; c++) {
+                int cell = r * cols + c;
+                for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++) {
+                    float ox = sortedX[k] - x;
+                    float oy = sortedY[k] - y;
+                    if (ox * ox + oy * oy <= r2) return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // Function to call fn(k, px, py) for every point in the cells that
+    // overlap the square around (x, y), where k is the point's position in
+    // cell order (items[k] is its index); callers filter by exact distance.
+    // The cell holding (x, y) is visited first, since it is the likeliest to
+    // hold close points; fn returns false to stop the walk early.
+    template <typename F>
+    void forEachNear(float x, float y, float radius, F fn) const {
+        int home = row(y) * cols + column(x);
+        for (int k = cellStart[home]; k < cellStart[home + 1]; k++) {
+            if (!fn(k, sortedX[k], sortedY[k])) return;
+        }
+        int c0 = column(x - radius), c1 = column(x + radius);
+        int r0 = row(y - radius), r1 = row(y + radius);
+        for (int r = r0; r <= r1; r++) {
+            for (int c = c0; c <= c1; c++) {
+                int cell = r * cols + c;
+                if (cell == home) continue;
+                for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++) {
+                    if (!fn(k, sortedX[k], sortedY[k])) return;
+                }
+            }
+        }
+    }
+};
+
+#endif
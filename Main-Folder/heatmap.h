@@ -0,0 +1,133 @@
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include <GL/glut.h>
+#include <algorithm>
+#include <vector>
+#include "jobs.h"
+
+// A grid of values shown as one colour-mapped texture stretched over a
+// rectangle. Callers write `values`, then upload them when they change;
+// drawing is a single textured quad however large the data behind it was.
+// Sizes are powers of two so plain GL 1.1 accepts the texture.
+struct Heatmap {
+    GLuint texture;
+    int width, height;
+    std::vector<float> values;         // width * height, row by row from the bottom
+    std::vector<unsigned char> pixels; // RGBA staging for the upload
+    unsigned char palette[256][4];     // Colour for each value step
+};
+
+// Function to fill the palette with a ramp from `low` to `high` (RGBA,
+// 0..1). Values of zero stay fully transparent so empty cells show the
+// scene underneath.
+inline void setHeatmapRamp(Heatmap& map, const float low[4], const float high[4]) {
+    for (int i = 0; i < 256; i++) {
+        float t = i / 255.0f;
+        for (int k = 0; k < 4; k++) {
+            map.palette[i][k] = (unsigned char)(255.0f * (low[k] + (high[k] - low[k]) * t) + 0.5f);
+        }
+    }
+    map.palette[0][3] = 0;
+}
+
+// Function to set up a heatmap and its texture; needs a current GL context
+inline void initHeatmap(Heatmap& map, int width, int height, const float low[4], const float high[4]) {
+    map.width = width;
+    map.height = height;
+    map.values.assign(width * height, 0.0f);
+    map.pixels.assign(width * height * 4, 0);
+    setHeatmapRamp(map, low, high);
+
+    glGenTextures(1, &map.texture);
+    glBindTexture(GL_TEXTURE_2D, map.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, map.pixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Function to colour-map the values into the texture; `scale` maps a value
+// to the top of the ramp at 1
+inline void uploadHeatmap(Heatmap& map, float scale) {
+    int count = map.width * map.height;
+    for (int i = 0; i < count; i++) {
+        float v = map.values[i] * scale;
+        int step = v <= 0.0f ? 0 : (v >= 1.0f ? 255 : 1 + (int)(v * 254.0f));
+        const unsigned char* colour = map.palette[step];
+        unsigned char* pixel = &map.pixels[i * 4];
+        pixel[0] = colour[0];
+        pixel[1] = colour[1];
+        pixel[2] = colour[2];
+        pixel[3] = colour[3];
+    }
+    glBindTexture(GL_TEXTURE_2D, map.texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, map.width, map.height, GL_RGBA, GL_UNSIGNED_BYTE, map.pixels.data());
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Function to count `count` points into the heatmap's values as a 2D
+// histogram over the rectangle (x0, y0)-(x1, y1); position(k, x, y) gives
+// point k. The points are split into one partition per thread, each counted
+// into its own private bins in `partitionBins` (no sharing, no atomics);
+// the bins are then summed cell by cell. Counts are whole numbers, so the
+// result doesn't depend on how the work was split. Returns the largest bin.
+template <typename Position>
+float binPoints(Heatmap& map, std::vector<float>& partitionBins, int count, Position position,
+    float x0, float y0, float x1, float y1, JobSystem& jobs) {
+    const int cells = map.width * map.height;
+    const int partitions = std::max(1, std::min(jobs.threadCount(), count));
+    const int chunk = (count + partitions - 1) / partitions;
+    partitionBins.assign((size_t)partitions * cells, 0.0f);
+
+    float* bins = partitionBins.data();
+    const int w = map.width, h = map.height;
+    const float sx = w / (x1 - x0), sy = h / (y1 - y0);
+    jobs.parallelFor(count, chunk > 0 ? chunk : 1, [=](int begin, int end) {
+        float* own = bins + (size_t)(begin / chunk) * cells;
+        for (int k = begin; k < end; k++) {
+            float px, py;
+            position(k, px, py);
+            int c = (int)((px - x0) * sx);
+            int r = (int)((py - y0) * sy);
+            c = c < 0 ? 0 : (c >= w ? w - 1 : c);
+            r = r < 0 ? 0 : (r >= h ? h - 1 : r);
+            own[r * w + c] += 1.0f;
+        }
+    });
+
+    float* values = map.values.data();
+    jobs.parallelFor(cells, 4096, [=](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            float sum = 0.0f;
+            for (int p = 0; p < partitions; p++) {
+                sum += bins[(size_t)p * cells + i];
+            }
+            values[i] = sum;
+        }
+    });
+    return count > 0 ? *std::max_element(map.values.begin(), map.values.end()) : 0.0f;
+}
+
+// Function to draw the heatmap over the rectangle (x0, y0)-(x1, y1)
+inline void drawHeatmap(const Heatmap& map, float x0, float y0, float x1, float y1) {
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, map.texture);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+    glBegin(GL_QUADS);
+    glTexCoord2f(0.0f, 0.0f);
+    glVertex2f(x0, y0);
+    glTexCoord2f(1.0f, 0.0f);
+    glVertex2f(x1, y0);
+    glTexCoord2f(1.0f, 1.0f);
+    glVertex2f(x1, y1);
+    glTexCoord2f(0.0f, 1.0f);
+    glVertex2f(x0, y1);
+    glEnd();
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
+}
+
+#endif
@@ -0,0 +1,179 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small work-stealing job system.
+// parallelFor() cuts a range into chunks and deals them out to per-worker
+// queues. Each worker pops its own queue from the back and steals from the
+// front of the others when it runs dry; the calling thread steals too until
+// the whole range is done, so a system with no workers just runs inline.
+class JobSystem {
+public:
+    // threads = 0 uses one worker per extra hardware thread
+    explicit JobSystem(int threads = 0) : stopping(false), pendingJobs(0) {
+        if (threads <= 0) {
+            threads = (int)std::thread::hardware_concurrency() - 1;
+        }
+        if (threads < 0) threads = 0;
+        for (int i = 0; i < threads; i++) {
+            queues.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+        }
+        for (int i = 0; i < threads; i++) {
+            workers.push_back(std::thread(&JobSystem::workerLoop, this, i));
+        }
+    }
+
+    ~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (size_t i = 0; i < workers.size(); i++) {
+            workers[i].join();
+        }
+    }
+
+    // Number of threads that can run chunks, including the caller
+    int threadCount() const { return (int)workers.size() + 1; }
+
+    // Runs fn(begin, end) over [0, count) in chunks of chunkSize and returns
+    // once every chunk has finished
+    void parallelFor(int count, int chunkSize, const std::function<void(int, int)>& fn) {
+        if (count <= 0) return;
+        if (chunkSize < 1) chunkSize = 1;
+        if (workers.empty() || count <= chunkSize) {
+            fn(0, count);
+            return;
+        }
+
+        Batch batch;
+        batch.fn = &fn;
+        batch.remaining = (count + chunkSize - 1) / chunkSize;
+
+        int chunk = 0;
+        for (int begin = 0; begin < count; begin += chunkSize, chunk++) {
+            Job job;
+            job.batch = &batch;
+            job.begin = begin;
+            job.end = begin + chunkSize < count ? begin + chunkSize : count;
+            WorkerQueue& queue = *queues[chunk % queues.size()];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.jobs.push_back(job);
+        }
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            pendingJobs += batch.remaining;
+        }
+        wake.notify_all();
+
+        // Help out until every chunk of this batch is done
+        Job job;
+        while (batch.remaining.load() > 0) {
+            if (steal((int)queues.size(), job)) {
+                run(job);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // Maps each chunk to a partial result and folds the partials in chunk
+    // order on the calling thread, so results don't depend on scheduling
+    template <typename T, typename Map, typename Combine>
+    T parallelReduce(int count, int chunkSize, T init, Map map, Combine combine) {
+        if (chunkSize < 1) chunkSize = 1;
+        int chunks = (count + chunkSize - 1) / chunkSize;
+        std::vector<T> partials(chunks > 0 ? chunks : 0, init);
+        parallelFor(count, chunkSize, [&](int begin, int end) {
+            partials[begin / chunkSize] = map(begin, end);
+        });
+        T result = init;
+        for (int i = 0; i < chunks; i++) {
+            result = combine(result, partials[i]);
+        }
+        return result;
+    }
+
+private:
+    struct Batch {
+        const std::function<void(int, int)>* fn;
+        std::atomic<int> remaining;
+    };
+
+    struct Job {
+        Batch* batch;
+        int begin, end;
+    };
+
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    bool stopping;
+    int pendingJobs; // Jobs queued but not yet taken; guarded by wakeMutex
+
+    void run(const Job& job) {
+        (*job.batch->fn)(job.begin, job.end);
+        job.batch->remaining.fetch_sub(1);
+    }
+
+    bool popOwn(int index, Job& job) {
+        WorkerQueue& queue = *queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty()) return false;
+        job = queue.jobs.back();
+        queue.jobs.pop_back();
+        taken();
+        return true;
+    }
+
+    // Takes the oldest job from any queue, starting after `self`
+    bool steal(int self, Job& job) {
+        int n = (int)queues.size();
+        for (int i = 1; i <= n; i++) {
+            WorkerQueue& queue = *queues[(self + i) % n];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.jobs.empty()) {
+                job = queue.jobs.front();
+                queue.jobs.pop_front();
+                taken();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void taken() {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        pendingJobs--;
+    }
+
+    void workerLoop(int index) {
+        Job job;
+        for (;;) {
+            if (popOwn(index, job) || steal(index, job)) {
+                run(job);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wake.wait(lock, [this] { return stopping || pendingJobs > 0; });
+            if (stopping) return;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,190 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include <cmath>
+#include <vector>
+#include "grid.h"
+#include "jobs.h"
+#include "random.h"
+
+// Fixed-capacity droplet pool stored as a structure of arrays.
+// Free slots sit on a stack; live slots are kept dense in `live` so updates
+// and drawing walk only droplets that exist. Nothing allocates after
+// construction.
+struct DropletPool {
+    int capacity;
+    std::vector<float> x, y;         // Position
+    std::vector<float> prevX, prevY; // Position at the previous step
+    std::vector<float> vx, vy;       // Velocity (units per second)
+    std::vector<float> life;         // Seconds left to live
+    std::vector<float> lifetime;     // Seconds the droplet lives in total
+    std::vector<float> alpha;        // Opacity, fades out with life
+    std::vector<int> freeSlots;      // Stack of unused slots
+    int freeCount;
+    std::vector<int> live;           // Slots in use, densely packed
+    int liveCount;
+
+    explicit DropletPool(int cap)
+        : capacity(cap), x(cap), y(cap), prevX(cap), prevY(cap), vx(cap), vy(cap),
+          life(cap), lifetime(cap), alpha(cap), freeSlots(cap), live(cap) {
+        clear();
+    }
+
+    // Function to return every slot to the free list
+    void clear() {
+        for (int i = 0; i < capacity; i++) {
+            freeSlots[i] = capacity - 1 - i; // Low slots come out first
+        }
+        freeCount = capacity;
+        liveCount = 0;
+    }
+
+    // Function to take a slot from the free list; returns -1 when full
+    int spawn(float px, float py, float dx, float dy, float seconds) {
+        if (freeCount == 0) return -1;
+        int slot = freeSlots[--freeCount];
+        x[slot] = prevX[slot] = px;
+        y[slot] = prevY[slot] = py;
+        vx[slot] = dx;
+        vy[slot] = dy;
+        life[slot] = lifetime[slot] = seconds;
+        alpha[slot] = 1.0f;
+        live[liveCount++] = slot;
+        return slot;
+    }
+
+    // Function to advance live droplets live[begin..end) by dt seconds
+    void integrate(int begin, int end, float dt, float drag) {
+        float keep = 1.0f - drag * dt;
+        if (keep < 0.0f) keep = 0.0f;
+        for (int k = begin; k < end; k++) {
+            int i = live[k];
+            prevX[i] = x[i];
+            prevY[i] = y[i];
+            x[i] += vx[i] * dt;
+            y[i] += vy[i] * dt;
+            vx[i] *= keep;
+            vy[i] *= keep;
+            life[i] -= dt;
+            alpha[i] = life[i] > 0.0f ? life[i] / lifetime[i] : 0.0f;
+        }
+    }
+
+    // Function to send expired droplets back to the free list (swap-remove)
+    void removeExpired() {
+        for (int k = 0; k < liveCount;) {
+            int i = live[k];
+            if (life[i] <= 0.0f) {
+                freeSlots[freeCount++] = i;
+                live[k] = live[--liveCount];
+            } else {
+                k++;
+            }
+        }
+    }
+};
+
+// A nozzle that keeps emitting droplets outward from a point for a while
+struct SprayEmitter {
+    float x, y;
+    float timeLeft; // Seconds the nozzle keeps emitting
+    float carry;    // Fractional droplet owed from the previous step
+};
+
+const int MAX_EMITTERS = 64;          // Sprays that can run at the same time
+const int MAX_DROPLETS = 131072;      // Droplets alive across all sprays
+const float EMITTER_DURATION = 0.3f;  // Seconds each spray emits for
+const float EMITTER_RATE = 8000.0f;   // Droplets per second per spray
+const float DROPLET_SPEED_MIN = 0.15f;
+const float DROPLET_SPEED_MAX = 0.45f;
+const float DROPLET_LIFETIME_MIN = 0.4f;
+const float DROPLET_LIFETIME_MAX = 0.8f;
+const float DROPLET_DRAG = 2.0f;      // Fraction of speed lost per second
+const float DROPLET_HIT_RADIUS = 0.02f;
+const int DROPLET_CHUNK_SIZE = 4096;  // Droplets per job when integrating
+
+// Every spray in the scene: emitters, the droplet pool and a grid of the
+// droplets rebuilt each step so mosquitoes can be tested against it
+struct SpraySystem {
+    DropletPool droplets;
+    SprayEmitter emitters[MAX_EMITTERS];
+    int emitterCount;
+    Random random;
+    PointGrid hitGrid;
+    std::vector<float> packedX, packedY; // Scratch: live droplet positions fed to the grid
+
+    SpraySystem() : droplets(MAX_DROPLETS), emitterCount(0), packedX(MAX_DROPLETS), packedY(MAX_DROPLETS) {
+        hitGrid.configure(-1.0f, -1.0f, 1.0f, 1.0f, DROPLET_HIT_RADIUS * 2.0f);
+    }
+
+    // Function to remove every spray and droplet
+    void clear() {
+        emitterCount = 0;
+        droplets.clear();
+        hitGrid.build(0, 0, 0);
+    }
+
+    // Function to start a spray at (x, y); returns false when all are busy
+    bool addEmitter(float x, float y) {
+        if (emitterCount == MAX_EMITTERS) return false;
+        SprayEmitter& e = emitters[emitterCount++];
+        e.x = x;
+        e.y = y;
+        e.timeLeft = EMITTER_DURATION;
+        e.carry = 0.0f;
+        return true;
+    }
+
+    // Function to advance droplets and emitters by dt seconds, then rebuild
+    // the hit grid from the droplets that are left
+    void step(float dt, JobSystem& jobs) {
+        DropletPool* pool = &droplets;
+        jobs.parallelFor(droplets.liveCount, DROPLET_CHUNK_SIZE, [=](int begin, int end) {
+            pool->integrate(begin, end, dt, DROPLET_DRAG);
+        });
+        droplets.removeExpired();
+
+        for (int e = 0; e < emitterCount;) {
+            SprayEmitter& emitter = emitters[e];
+            float owed = emitter.carry + EMITTER_RATE * dt;
+            int count = (int)owed;
+            emitter.carry = owed - count;
+            for (int n = 0; n < count; n++) {
+                float angle = random.range(0.0f, 6.2831853f);
+                float speed = random.range(DROPLET_SPEED_MIN, DROPLET_SPEED_MAX);
+                float seconds = random.range(DROPLET_LIFETIME_MIN, DROPLET_LIFETIME_MAX);
+                if (droplets.spawn(emitter.x, emitter.y, speed * cosf(angle),
+                        speed * sinf(angle), seconds) < 0) {
+                    break;
+                }
+            }
+            emitter.timeLeft -= dt;
+            if (emitter.timeLeft <= 0.0f) {
+                emitters[e] = emitters[--emitterCount];
+            } else {
+                e++;
+            }
+        }
+
+        // Pack live positions so the grid reads them densely
+        int n = droplets.liveCount;
+        for (int k = 0; k < n; k++) {
+            int i = droplets.live[k];
+            packedX[k] = droplets.x[i];
+            packedY[k] = droplets.y[i];
+        }
+        hitGrid.build(packedX.data(), packedY.data(), n, 1, droplets.live.data());
+    }
+
+    // Function to check whether a droplet is close enough to hit (x, y)
+    bool hits(float x, float y) const {
+        return hitGrid.anyWithin(x, y, DROPLET_HIT_RADIUS);
+    }
+
+    // Function to tell whether anything is still spraying
+    bool active() const {
+        return emitterCount > 0 || droplets.liveCount > 0;
+    }
+};
+
+#endif
@@ -0,0 +1,210 @@
+#ifndef POPULATION_H
+#define POPULATION_H
+
+#include <cstring>
+#include <memory>
+#include <vector>
+#include "jobs.h"
+#include "random.h"
+
+// Aquatic life stages kept in the brood store; adults live in the swarm
+enum BroodStage {
+    STAGE_EGG,
+    STAGE_LARVA
+};
+
+const int MAX_SITES = 4;           // Breeding sites a scene can have
+const int BROOD_CHUNK_SIZE = 4096; // Eggs and larvae per storage chunk
+
+// Egg and larva timing and survival (days)
+const float EGG_HATCH_MIN = 2.0f;
+const float EGG_HATCH_MAX = 5.0f;
+const float EGG_DORMANT_DAYS = 60.0f;    // Eggs on dry ground last this long
+const float LARVA_DAYS_MIN = 5.0f;
+const float LARVA_DAYS_MAX = 10.0f;
+const float LARVA_DAILY_DEATH = 0.05f;   // Chance per day before crowding
+const float CROWDING_DAILY_DEATH = 0.3f; // Extra chance per day at full capacity
+
+// A patch of water that eggs are laid in and larvae grow in
+struct BreedingSite {
+    float x, y;
+    bool wet;            // Larvae die and eggs lie dormant while dry
+    float larvaCapacity; // Larvae the site feeds before crowding kills more
+    int eggs, larvae;    // Counted during the last brood step
+};
+
+// A fixed-size block of eggs and larvae stored as a structure of arrays
+struct BroodChunk {
+    int count;
+    float age[BROOD_CHUNK_SIZE];     // Days in the current stage
+    float develop[BROOD_CHUNK_SIZE]; // Days the current stage lasts
+    unsigned char stage[BROOD_CHUNK_SIZE];
+    unsigned char site[BROOD_CHUNK_SIZE];
+
+    BroodChunk() : count(0) {}
+
+    // Function to overwrite entity i with entity j
+    void copy(int i, const BroodChunk& from, int j) {
+        age[i] = from.age[j];
+        develop[i] = from.develop[j];
+        stage[i] = from.stage[j];
+        site[i] = from.site[j];
+    }
+};
+
+// Per-site counts from a brood step
+struct BroodTally {
+    int eggs[MAX_SITES];
+    int larvae[MAX_SITES];
+    int emerged[MAX_SITES]; // Larvae that became adults this step
+
+    BroodTally() {
+        memset(this, 0, sizeof(*this));
+    }
+
+    BroodTally& operator+=(const BroodTally& other) {
+        for (int s = 0; s < MAX_SITES; s++) {
+            eggs[s] += other.eggs[s];
+            larvae[s] += other.larvae[s];
+            emerged[s] += other.emerged[s];
+        }
+        return *this;
+    }
+};
+
+// Eggs and larvae packed into fixed-size chunks.
+// Every chunk but the last is full: a step removes entities inside each
+// chunk, then compact() refills the holes from the tail. Chunks emptied at
+// the tail are kept for reuse, so millions of births and deaths a step
+// neither fragment the store nor reallocate it.
+struct BroodStore {
+    std::vector<std::unique_ptr<BroodChunk>> chunks; // [0, used) hold entities
+    int used;
+
+    BroodStore() : used(0) {}
+
+    // Function to drop every entity, keeping the chunks
+    void clear() {
+        for (int c = 0; c < used; c++) {
+            chunks[c]->count = 0;
+        }
+        used = 0;
+    }
+
+    // Function to count the stored entities
+    long long size() const {
+        return used == 0 ? 0 : (long long)(used - 1) * BROOD_CHUNK_SIZE + chunks[used - 1]->count;
+    }
+
+    // Function to append an entity at the end of the last chunk
+    void add(int stage, int site, float develop) {
+        if (used == 0 || chunks[used - 1]->count == BROOD_CHUNK_SIZE) {
+            if (used == (int)chunks.size()) {
+                chunks.push_back(std::unique_ptr<BroodChunk>(new BroodChunk()));
+            }
+            chunks[used]->count = 0;
+            used++;
+        }
+        BroodChunk& chunk = *chunks[used - 1];
+        int i = chunk.count++;
+        chunk.age[i] = 0.0f;
+        chunk.develop[i] = develop;
+        chunk.stage[i] = (unsigned char)stage;
+        chunk.site[i] = (unsigned char)site;
+    }
+
+    // Function to move entities from the tail chunks into holes in the
+    // front chunks until only the last chunk is partly filled
+    void compact() {
+        int front = 0;
+        int back = used - 1;
+        while (front < back) {
+            BroodChunk& f = *chunks[front];
+            BroodChunk& b = *chunks[back];
+            if (f.count == BROOD_CHUNK_SIZE) {
+                front++;
+            } else if (b.count == 0) {
+                back--;
+            } else {
+                f.copy(f.count++, b, --b.count);
+            }
+        }
+        while (used > 0 && chunks[used - 1]->count == 0) {
+            used--;
+        }
+    }
+};
+
+// Function to age one chunk by `days`. Eggs hatch once their site is wet;
+// larvae die of drought, crowding or chance, or emerge as adults. Removed
+// entities are swap-removed within the chunk.
+inline BroodTally stepBroodChunk(BroodChunk& chunk, const BreedingSite* sites, float days, Random rng) {
+    BroodTally tally;
+    for (int i = 0; i < chunk.count;) {
+        int s = chunk.site[i];
+        const BreedingSite& site = sites[s];
+        bool removed = false;
+        chunk.age[i] += days;
+
+        if (chunk.stage[i] == STAGE_EGG) {
+            if (site.wet && chunk.age[i] >= chunk.develop[i]) {
+                chunk.stage[i] = STAGE_LARVA; // Hatch
+                chunk.age[i] = 0.0f;
+                chunk.develop[i] = rng.range(LARVA_DAYS_MIN, LARVA_DAYS_MAX);
+            } else if (chunk.age[i] >= EGG_DORMANT_DAYS) {
+                removed = true;
+            }
+        } else if (!site.wet) {
+            removed = true; // Larvae need water
+        } else {
+            float crowding = site.larvaCapacity > 0.0f ? site.larvae / site.larvaCapacity : 1.0f;
+            float deathChance = (LARVA_DAILY_DEATH + CROWDING_DAILY_DEATH * crowding) * days;
+            if (rng.nextFloat() < deathChance) {
+                removed = true;
+            } else if (chunk.age[i] >= chunk.develop[i]) {
+                tally.emerged[s]++;
+                removed = true;
+            }
+        }
+
+        if (removed) {
+            chunk.copy(i, chunk, --chunk.count); // Re-check the moved entity at i
+        } else {
+            if (chunk.stage[i] == STAGE_EGG) {
+                tally.eggs[s]++;
+            } else {
+                tally.larvae[s]++;
+            }
+            i++;
+        }
+    }
+    return tally;
+}
+
+// Function to advance every egg and larva by `days`, one job per chunk,
+// then compact the store. Each chunk draws from its own stream derived from
+// the seed and tick, so results don't depend on the thread count.
+inline BroodTally stepBrood(BroodStore& store, BreedingSite* sites, int siteCount, float days,
+    uint64_t seed, uint64_t tick, JobSystem& jobs) {
+    BroodStore* target = &store;
+    const BreedingSite* siteData = sites;
+    uint64_t tickSeed = seed + tick * 0x9E3779B97F4A7C15ULL;
+    BroodTally total = jobs.parallelReduce(store.used, 1, BroodTally(),
+        [=](int begin, int end) {
+            BroodTally tally;
+            for (int c = begin; c < end; c++) {
+                tally += stepBroodChunk(*target->chunks[c], siteData, days, Random(tickSeed, STREAM_WORKER + c));
+            }
+            return tally;
+        },
+        [](BroodTally a, const BroodTally& b) { return a += b; });
+    store.compact();
+
+    for (int s = 0; s < siteCount; s++) {
+        sites[s].eggs = total.eggs[s];
+        sites[s].larvae = total.larvae[s];
+    }
+    return total;
+}
+
+#endif
@@ -0,0 +1,258 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// Per-phase frame timing with an on-screen overlay.
+// Wrap a phase in PROFILE_SCOPE(phase) and call PROFILE_FRAME() once per
+// frame; the program names its phases with profilerSetup(). Timers are for
+// the main thread only. Build with -DPROFILER_ENABLED=0 to compile every
+// timer and the overlay out.
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+const int MAX_PROFILE_PHASES = 16;
+const int PROFILE_HISTORY = 120;        // Frames kept in the ring buffer
+const int PROFILE_LABEL_INTERVAL = 30;  // Frames between overlay text refreshes
+
+#if PROFILER_ENABLED
+
+#include <chrono>
+#include <cstdio>
+#include "text.h"
+
+// Milliseconds spent in each phase during one frame
+struct FrameProfile {
+    float frameMs; // Time from the start of this frame to the start of the next
+    float phaseMs[MAX_PROFILE_PHASES];
+};
+
+struct Profiler {
+    const char* const* names;
+    int phaseCount;
+    FrameProfile history[PROFILE_HISTORY]; // Ring buffer of finished frames
+    int newest;                            // Index of the latest finished frame
+    int frames;                            // Frames finished so far
+    FrameProfile current;                  // Frame being recorded
+    double totalMs[MAX_PROFILE_PHASES];    // Per-phase totals since startup
+    std::chrono::steady_clock::time_point frameStart;
+    bool started;
+    bool visible;
+    bool labelsReady;
+    TextLabel labels[MAX_PROFILE_PHASES + 1]; // Frame time, then one per phase
+
+    Profiler() : names(0), phaseCount(0), newest(0), frames(0), started(false), visible(false), labelsReady(false) {
+        memset(history, 0, sizeof(history));
+        memset(&current, 0, sizeof(current));
+        memset(totalMs, 0, sizeof(totalMs));
+    }
+};
+
+inline Profiler& profiler() {
+    static Profiler instance;
+    return instance;
+}
+
+// Function to name the phases; names must outlive the profiler
+inline void profilerSetup(const char* const* names, int count) {
+    Profiler& p = profiler();
+    p.names = names;
+    p.phaseCount = count < MAX_PROFILE_PHASES ? count : MAX_PROFILE_PHASES;
+}
+
+// Function to close the current frame into the ring buffer and start the next
+inline void profilerBeginFrame() {
+    Profiler& p = profiler();
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (p.started) {
+        p.current.frameMs = std::chrono::duration<float, std::milli>(now - p.frameStart).count();
+        p.newest = (p.newest + 1) % PROFILE_HISTORY;
+        p.history[p.newest] = p.current;
+        p.frames++;
+        memset(&p.current, 0, sizeof(p.current));
+    }
+    p.frameStart = now;
+    p.started = true;
+}
+
+// Times the enclosing scope into one phase of the current frame
+struct ScopedTimer {
+    int phase;
+    std::chrono::steady_clock::time_point start;
+
+    explicit ScopedTimer(int p) : phase(p), start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedTimer() {
+        float ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+        Profiler& p = profiler();
+        p.current.phaseMs[phase] += ms;
+        p.totalMs[phase] += ms;
+    }
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(phase) ScopedTimer PROFILE_CONCAT(profileScope, __LINE__)(phase)
+#define PROFILE_FRAME() profilerBeginFrame()
+
+// Function to show or hide the overlay
+inline void toggleProfilerOverlay() {
+    profiler().visible = !profiler().visible;
+}
+
+// Colour of a phase in the graph and its label
+inline void profilerPhaseColor(int phase, float& r, float& g, float& b) {
+    static const float palette[8][3] = {
+        { 0.9f, 0.3f, 0.3f }, { 0.3f, 0.8f, 0.3f }, { 0.3f, 0.5f, 1.0f }, { 1.0f, 0.8f, 0.2f },
+        { 0.8f, 0.4f, 1.0f }, { 0.2f, 0.9f, 0.9f }, { 1.0f, 0.5f, 0.1f }, { 0.7f, 0.7f, 0.7f }
+    };
+    r = palette[phase % 8][0];
+    g = palette[phase % 8][1];
+    b = palette[phase % 8][2];
+}
+
+// Function to fetch the frame finished `ago` frames before the newest
+inline const FrameProfile& profiledFrame(int ago) {
+    const Profiler& p = profiler();
+    return p.history[(p.newest - ago + PROFILE_HISTORY) % PROFILE_HISTORY];
+}
+
+// Function to re-record the overlay text from averages over the history
+inline void refreshProfilerLabels() {
+    Profiler& p = profiler();
+    if (!p.labelsReady) {
+        initLabel(p.labels[0], GLUT_BITMAP_HELVETICA_12, 0.02f, 0.285f, 1.0f, 1.0f, 1.0f);
+        for (int i = 0; i < p.phaseCount; i++) {
+            float r, g, b;
+            profilerPhaseColor(i, r, g, b);
+            initLabel(p.labels[i + 1], GLUT_BITMAP_HELVETICA_12, 0.28f, 0.25f - 0.025f * i, r, g, b);
+        }
+        p.labelsReady = true;
+    }
+    int count = p.frames < PROFILE_HISTORY ? p.frames : PROFILE_HISTORY;
+    if (count == 0) return;
+
+    float frameSum = 0.0f;
+    float phaseSum[MAX_PROFILE_PHASES] = {};
+    for (int f = 0; f < count; f++) {
+        const FrameProfile& frame = profiledFrame(f);
+        frameSum += frame.frameMs;
+        for (int i = 0; i < p.phaseCount; i++) {
+            phaseSum[i] += frame.phaseMs[i];
+        }
+    }
+    char text[64];
+    float frameAvg = frameSum / count;
+    snprintf(text, sizeof(text), "Frame %.2f ms (%.0f fps)", frameAvg, frameAvg > 0.0f ? 1000.0f / frameAvg : 0.0f);
+    setLabelText(p.labels[0], text);
+    for (int i = 0; i < p.phaseCount; i++) {
+        snprintf(text, sizeof(text), "%s %.2f ms", p.names[i], phaseSum[i] / count);
+        setLabelText(p.labels[i + 1], text);
+    }
+}
+
+// Function to draw the rolling frame graph, stacked by phase, and the
+// per-phase averages in the bottom-left corner. Sets up its own 2D state,
+// so it can be called at the end of any display function.
+inline void drawProfilerOverlay() {
+    Profiler& p = profiler();
+    if (!p.visible) return;
+    if (!p.labelsReady || p.frames % PROFILE_LABEL_INTERVAL == 0) {
+        refreshProfilerLabels();
+    }
+
+    glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT | GL_COLOR_BUFFER_BIT | GL_LINE_BIT);
+    glDisable(GL_LIGHTING);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_TEXTURE_2D);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glMatrixMode(GL_PROJECTION);
+    glPushMatrix();
+    glLoadIdentity();
+    gluOrtho2D(0.0, 1.0, 0.0, 1.0);
+    glMatrixMode(GL_MODELVIEW);
+    glPushMatrix();
+    glLoadIdentity();
+
+    // Panel behind the graph and text
+    glColor4f(0.0f, 0.0f, 0.0f, 0.6f);
+    glRectf(0.01f, 0.01f, 0.46f, 0.31f);
+
+    // The graph spans 0.02..0.26 across and two 60 Hz frames (33.3 ms) up
+    const float left = 0.02f, bottom = 0.02f, width = 0.24f, height = 0.24f;
+    const float scale = height / 33.3f;
+    const float column = width / PROFILE_HISTORY;
+    int count = p.frames < PROFILE_HISTORY ? p.frames : PROFILE_HISTORY;
+
+    // One column per frame, newest on the right, stacked by phase
+    glBegin(GL_QUADS);
+    for (int f = 0; f < count; f++) {
+        const FrameProfile& frame = profiledFrame(f);
+        float x1 = left + width - f * column;
+        float x0 = x1 - column;
+        float y = bottom;
+        for (int i = 0; i < p.phaseCount; i++) {
+            float top = y + frame.phaseMs[i] * scale;
+            if (top > bottom + height) top = bottom + height;
+            float r, g, b;
+            profilerPhaseColor(i, r, g, b);
+            glColor4f(r, g, b, 0.9f);
+            glVertex2f(x0, y);
+            glVertex2f(x1, y);
+            glVertex2f(x1, top);
+            glVertex2f(x0, top);
+            y = top;
+        }
+    }
+    glEnd();
+
+    // Whole frame time as a line, with the 60 Hz budget marked
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+    glBegin(GL_LINE_STRIP);
+    for (int f = 0; f < count; f++) {
+        float ms = profiledFrame(f).frameMs;
+        float y = bottom + (ms < 33.3f ? ms : 33.3f) * scale;
+        glVertex2f(left + width - (f + 0.5f) * column, y);
+    }
+    glEnd();
+    glColor4f(1.0f, 0.3f, 0.3f, 0.8f);
+    glBegin(GL_LINES);
+    glVertex2f(left, bottom + 16.67f * scale);
+    glVertex2f(left + width, bottom + 16.67f * scale);
+    glEnd();
+
+    for (int i = 0; i <= p.phaseCount; i++) {
+        drawLabel(p.labels[i]);
+    }
+
+    glPopMatrix();
+    glMatrixMode(GL_PROJECTION);
+    glPopMatrix();
+    glMatrixMode(GL_MODELVIEW);
+    glPopAttrib();
+}
+
+// Function to print the total and per-frame average of every phase that ran
+inline void printProfilerSummary() {
+    const Profiler& p = profiler();
+    int frames = p.frames + (p.started ? 1 : 0); // Include the frame still open
+    if (frames == 0) return;
+    printf("Phase breakdown (%d frames):\n", frames);
+    for (int i = 0; i < p.phaseCount; i++) {
+        if (p.totalMs[i] == 0.0) continue;
+        printf("  %-12s %10.1f ms total %8.3f ms/frame\n", p.names[i], p.totalMs[i], p.totalMs[i] / frames);
+    }
+}
+
+#else
+
+#define PROFILE_SCOPE(phase) ((void)0)
+#define PROFILE_FRAME() ((void)0)
+inline void profilerSetup(const char* const*, int) {}
+inline void toggleProfilerOverlay() {}
+inline void drawProfilerOverlay() {}
+inline void printProfilerSummary() {}
+
+#endif
+
+#endif
@@ -1,14 +1,28 @@
 #include <GL/glut.h>
 #include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include <vector>
 #include <string>
+#include "belts.h"
+#include "bodies.h"
+#include "geometry.h"
+#include "jobs.h"
+#include "nbody.h"
+#include "random.h"
+#include "redraw.h"
+#include "text.h"
 
 // Constants
 const float PI = 3.14159265359f;
 const int WINDOW_WIDTH = 1200;
 const int WINDOW_HEIGHT = 800;
 const int CIRCLE_SEGMENTS = 100;
+const float DEG = PI / 180.0f;
+const double TIME_STEP = 0.01;    // Simulated time per tick at 1x speed
+const double EARTH_YEAR = 2.1085; // Simulated time of one Earth orbit
+const double SEEK_YEARS = 100.0;  // How far [ and ] jump
 
 // Global variables
 float cameraDistance = 50.0f;
@@ -18,27 +32,95 @@ bool mousePressed = false;
 int lastMouseX, lastMouseY;
 bool showOrbits = true;
 bool isPaused = false;
+bool clockRunning = false; // An update() is scheduled; it stops while paused
 float timeSpeed = 1.0f;
-float globalTime = 0.0f;
+double globalTime = 0.0; // Simulated time; every body's position is a function of it
 int selectedPlanet = -1;
 
-// Planet structure
-struct Planet {
-    std::string name;
-    float radius;
-    float distance;
-    float speed;
-    float angle;
-    float r, g, b;
-    std::vector<Planet> moons;
-    
-    Planet(std::string n, float rad, float dist, float spd, float red, float green, float blue)
-        : name(n), radius(rad), distance(dist), speed(spd), angle(0), r(red), g(green), b(blue) {}
-};
+// View state for picking sphere detail: the camera matrix of the current
+// frame and the pixels per unit of size at unit depth
+const float FIELD_OF_VIEW = 45.0f;
+GLfloat viewMatrix[16];
+GLfloat projectionMatrix[16];
+float projectionScale = 1.0f;
+
+// Culling: the frustum of the current frame, and which bodies and orbit
+// rings reach into it. Each orbit is bounded by the sphere around its
+// ellipse's centre that holds the whole ellipse.
+Frustum frustum;
+std::vector<unsigned char> bodyVisible, orbitVisible;
+std::vector<float> orbitX, orbitY, orbitZ, orbitReach;
+
+// Starfield: generated once at startup into vertex and colour arrays, then
+// recorded into a display list so each frame draws it with one call
+const int DEFAULT_STAR_COUNT = 5000;
+const float STAR_SHELL_INNER = 400.0f; // Stars sit in a shell well outside the orbits
+const float STAR_SHELL_OUTER = 600.0f;
+const float STAR_MAG_BRIGHTEST = -1.5f; // Apparent magnitude range (lower is brighter)
+const float STAR_MAG_FAINTEST = 6.5f;
+int starCount = DEFAULT_STAR_COUNT;
+Random starRandom(0, STREAM_STARS);
+std::vector<float> starVertices; // x, y, z per star
+std::vector<float> starColors;   // r, g, b per star, scaled by brightness
+GLuint starList = 0;
+
+// Solar system data: every body in flat arrays, the Sun first
+const int SUN = 0;
+BodyTable bodies;
+std::vector<int> planetIds; // Bodies orbiting the Sun, in the order keys 1-8 select them
+
+// N-body mode: instead of following their circles, the bodies and a disc of
+// test particles pull on each other through a Barnes-Hut tree. The Sun's
+// mass puts Earth on the same period as the circular mode; planets weigh
+// in with the cube of their drawn radius, moons and particles barely at all.
+// The drawn moons sit far outside their planets' Hill spheres
+// r_H = a (m / 3M)^(1/3), and no planet mass could hold them there without
+// scattering its neighbours, so moons are simulated on orbits shrunk to
+// MOON_HILL_FRACTION of r_H and drawn scaled back out. A moon then goes
+// round in a fixed share of its planet's year, which needs steps no longer
+// than TIME_STEP: fast-forward splits a tick into several steps.
+const float SUN_MASS = 29970.0f;
+const float PLANET_DENSITY = 1e-4f * SUN_MASS; // Mass per unit of radius cubed
+const float MOON_MASS = 1e-3f;
+const float PARTICLE_MASS = 1e-6f;
+const float MOON_HILL_FRACTION = 0.3f; // Well inside the ~0.5 r_H where moons stay bound
+const float PARTICLE_DISC_INNER = 22.0f; // Between Mars and Jupiter
+const float PARTICLE_DISC_OUTER = 28.0f;
+const float PARTICLE_DISC_THICKNESS = 0.5f;
+const int DEFAULT_NBODY_PARTICLES = 2000;
+bool nbodyMode = false;
+int nbodyParticles = DEFAULT_NBODY_PARTICLES;
+float nbodyTheta = 0.7f;
+NBodySystem nbody; // Scene bodies first, then the particles
+std::vector<float> moonDrawScale; // Drawn over simulated distance from the parent, per body
+Random particleRandom(0, STREAM_PARTICLES);
+std::vector<float> particleVertices; // x, y, z per particle, refilled each frame
 
-// Solar system data
-std::vector<Planet> planets;
-Planet sun("Sun", 3.0f, 0.0f, 0.0f, 1.0f, 0.8f, 0.0f);
+// Asteroid and Kuiper belts: massless particles on fixed orbits around the
+// Sun, placed from globalTime like the bodies and drawn as points. The
+// default counts are a light load; raise them with --asteroids and
+// --kuiper (up to a million each) to stress the renderer.
+const BeltShape ASTEROID_BELT = {23.0f, 27.0f, 0.1f, 10.0f * DEG};
+const BeltShape KUIPER_BELT = {65.0f, 90.0f, 0.2f, 15.0f * DEG};
+const int DEFAULT_ASTEROIDS = 20000;
+const int DEFAULT_KUIPER_OBJECTS = 30000;
+bool showBelts = true;
+int asteroidCount = DEFAULT_ASTEROIDS;
+int kuiperCount = DEFAULT_KUIPER_OBJECTS;
+Belt asteroidBelt, kuiperBelt;
+Random beltRandom(0, STREAM_BELTS);
+JobSystem jobs;
+
+// HUD: the fixed lines and the calls to each changing line's label are
+// recorded once into one display list, drawn inside a single 2D pass.
+// Labels are re-recorded only when the values they show change.
+enum HudLabel { HUD_STATUS, HUD_SELECTED, HUD_NBODY, NUM_HUD_LABELS };
+TextLabel hudLabels[NUM_HUD_LABELS];
+GLuint hudList = 0;
+float shownSpeed = -1.0f; // Values behind the labels' current text
+int shownYear = 0;
+bool shownPaused = false;
+int shownSelected = -2;
 
 // Function prototypes
 void initOpenGL();
@@ -51,10 +133,20 @@ void mouse(int button, int state, int x, int y);
 void mouseMotion(int x, int y);
 void update(int value);
 void drawCircle(float radius, int segments = CIRCLE_SEGMENTS);
-void drawOrbit(float radius);
-void drawPlanet(const Planet& planet, float x, float y, float z);
-void drawText(float x, float y, const std::string& text);
+void drawOrbit(int body);
+void drawBody(int body);
+void initHud();
+void updateHud();
+void drawHud();
+void buildStars();
 void drawStars();
+float projectedRadius(float radius, float x, float y, float z);
+int sphereLevel(float radius, float x, float y, float z);
+void cullScene();
+void startNBody();
+void drawParticles();
+void placeBelts();
+void drawBelt(const Belt& belt, float r, float g, float b);
 
 // Bresenham's circle algorithm implementation
 void plotCirclePoints(int cx, int cy, int x, int y) {
@@ -106,105 +198,341 @@ void initOpenGL() {
     
     glClearColor(0.0f, 0.0f, 0.1f, 1.0f);
     
+    sphereMesh(0); // Build every sphere level up front
+    unitRingList(0); // And every orbit ring level
+    buildStars();
+    initHud();
+    
     setupSolarSystem();
 }
 
 void setupSolarSystem() {
-    planets.clear();
+    bodies.clear();
+    planetIds.clear();
+    bodies.add("Sun", -1, 3.0f, 0.0f, 0.0f, 1.0f, 0.8f, 0.0f);
     
-    // Create planets with realistic-ish properties (scaled for visualization)
-    planets.push_back(Planet("Mercury", 0.4f, 8.0f, 4.74f, 0.7f, 0.7f, 0.7f));
-    planets.push_back(Planet("Venus", 0.9f, 11.0f, 3.50f, 1.0f, 0.8f, 0.0f));
+    // Create planets with realistic-ish properties (scaled for visualization).
+    // Shapes are eccentricity, inclination, ascending node and periapsis.
+    int mercury = bodies.add("Mercury", SUN, 0.4f, 8.0f, 4.74f, 0.7f, 0.7f, 0.7f);
+    bodies.shapeOrbit(mercury, 0.206f, 7.0f * DEG, 48.3f * DEG, 29.1f * DEG);
+    int venus = bodies.add("Venus", SUN, 0.9f, 11.0f, 3.50f, 1.0f, 0.8f, 0.0f);
+    bodies.shapeOrbit(venus, 0.007f, 3.4f * DEG, 76.7f * DEG, 54.9f * DEG);
     
     // Earth with Moon
-    Planet earth("Earth", 1.0f, 15.0f, 2.98f, 0.2f, 0.6f, 1.0f);
-    earth.moons.push_back(Planet("Moon", 0.25f, 2.5f, 13.2f, 0.8f, 0.8f, 0.8f));
-    planets.push_back(earth);
+    int earth = bodies.add("Earth", SUN, 1.0f, 15.0f, 2.98f, 0.2f, 0.6f, 1.0f);
+    bodies.shapeOrbit(earth, 0.017f, 0.0f, 0.0f, 102.9f * DEG);
+    int moon = bodies.add("Moon", earth, 0.25f, 2.5f, 13.2f, 0.8f, 0.8f, 0.8f);
+    bodies.shapeOrbit(moon, 0.055f, 5.1f * DEG, 125.1f * DEG, 318.1f * DEG);
     
-    planets.push_back(Planet("Mars", 0.5f, 20.0f, 2.41f, 1.0f, 0.4f, 0.2f));
+    int mars = bodies.add("Mars", SUN, 0.5f, 20.0f, 2.41f, 1.0f, 0.4f, 0.2f);
+    bodies.shapeOrbit(mars, 0.093f, 1.85f * DEG, 49.6f * DEG, 286.5f * DEG);
     
     // Jupiter with moons
-    Planet jupiter("Jupiter", 2.5f, 30.0f, 1.31f, 1.0f, 0.6f, 0.2f);
-    jupiter.moons.push_back(Planet("Io", 0.15f, 4.0f, 17.3f, 1.0f, 1.0f, 0.0f));
-    jupiter.moons.push_back(Planet("Europa", 0.13f, 5.0f, 13.7f, 0.8f, 0.9f, 1.0f));
-    planets.push_back(jupiter);
-    
-    planets.push_back(Planet("Saturn", 2.0f, 40.0f, 0.97f, 1.0f, 0.8f, 0.5f));
-    planets.push_back(Planet("Uranus", 1.5f, 50.0f, 0.68f, 0.2f, 0.8f, 1.0f));
-    planets.push_back(Planet("Neptune", 1.4f, 60.0f, 0.54f, 0.2f, 0.2f, 1.0f));
+    int jupiter = bodies.add("Jupiter", SUN, 2.5f, 30.0f, 1.31f, 1.0f, 0.6f, 0.2f);
+    bodies.shapeOrbit(jupiter, 0.049f, 1.3f * DEG, 100.5f * DEG, 273.9f * DEG);
+    int io = bodies.add("Io", jupiter, 0.15f, 4.0f, 17.3f, 1.0f, 1.0f, 0.0f);
+    bodies.shapeOrbit(io, 0.004f, 0.05f * DEG, 0.0f, 0.0f);
+    int europa = bodies.add("Europa", jupiter, 0.13f, 5.0f, 13.7f, 0.8f, 0.9f, 1.0f);
+    bodies.shapeOrbit(europa, 0.009f, 0.47f * DEG, 0.0f, 0.0f);
+    
+    int saturn = bodies.add("Saturn", SUN, 2.0f, 40.0f, 0.97f, 1.0f, 0.8f, 0.5f);
+    bodies.shapeOrbit(saturn, 0.057f, 2.5f * DEG, 113.7f * DEG, 339.4f * DEG);
+    int uranus = bodies.add("Uranus", SUN, 1.5f, 50.0f, 0.68f, 0.2f, 0.8f, 1.0f);
+    bodies.shapeOrbit(uranus, 0.046f, 0.8f * DEG, 74.0f * DEG, 96.7f * DEG);
+    int neptune = bodies.add("Neptune", SUN, 1.4f, 60.0f, 0.54f, 0.2f, 0.2f, 1.0f);
+    bodies.shapeOrbit(neptune, 0.010f, 1.8f * DEG, 131.8f * DEG, 273.2f * DEG);
+    
+    int planets[] = {mercury, venus, earth, mars, jupiter, saturn, uranus, neptune};
+    planetIds.assign(planets, planets + 8);
+    
+    bodies.updatePositions(globalTime);
+    
+    beltRandom.seed(0, STREAM_BELTS);
+    generateBelt(asteroidBelt, asteroidCount, ASTEROID_BELT, SUN_MASS, beltRandom);
+    generateBelt(kuiperBelt, kuiperCount, KUIPER_BELT, SUN_MASS, beltRandom);
+    placeBelts();
 }
 
 void drawCircle(float radius, int segments) {
     glBegin(GL_TRIANGLE_FAN);
     glVertex3f(0, 0, 0);
-    for (int i = 0; i <= segments; i++) {
-        float angle = 2.0f * PI * i / segments;
-        glVertex3f(cos(angle) * radius, sin(angle) * radius, 0);
+    const CircleTable& unit = unitCircle(segments);
+    for (int i = 0; i <= unit.segments; i++) {
+        glVertex3f(unit.c[i] * radius, unit.s[i] * radius, 0);
     }
     glEnd();
 }
 
-void drawOrbit(float radius) {
+// Orbits replay a baked unit ring, stretched into the body's ellipse and
+// turned into its plane around the parent. Larger orbits on screen get
+// more segments.
+void drawOrbit(int body) {
+    int parent = bodies.parent[body];
+    float a = bodies.distance[body];
+    float e = bodies.eccentricity[body];
+    float b = a * sqrt(1.0f - e * e);
+    float px = bodies.px[body], py = bodies.py[body], pz = bodies.pz[body];
+    float qx = bodies.qx[body], qy = bodies.qy[body], qz = bodies.qz[body];
+    
+    // Ring X runs towards periapsis, ring Z along the orbit, ring Y along the normal
+    float cx = bodies.x[parent] - a * e * px;
+    float cy = bodies.y[parent] - a * e * py;
+    float cz = bodies.z[parent] - a * e * pz;
+    GLfloat ellipse[16] = {
+        a * px, a * py, a * pz, 0,
+        pz * qy - py * qz, px * qz - pz * qx, py * qx - px * qy, 0,
+        b * qx, b * qy, b * qz, 0,
+        cx, cy, cz, 1
+    };
+    
     glDisable(GL_LIGHTING);
     glColor3f(0.3f, 0.3f, 0.3f);
-    glBegin(GL_LINE_LOOP);
-    for (int i = 0; i < CIRCLE_SEGMENTS; i++) {
-        float angle = 2.0f * PI * i / CIRCLE_SEGMENTS;
-        glVertex3f(cos(angle) * radius, 0, sin(angle) * radius);
-    }
-    glEnd();
+    glPushMatrix();
+    glMultMatrixf(ellipse);
+    glCallList(unitRingList(ringLevelForPixels(projectedRadius(a, cx, cy, cz))));
+    glPopMatrix();
     glEnable(GL_LIGHTING);
 }
 
-void drawPlanet(const Planet& planet, float x, float y, float z) {
+void drawBody(int body) {
+    float x = bodies.x[body], y = bodies.y[body], z = bodies.z[body];
     glPushMatrix();
     glTranslatef(x, y, z);
+    glColor3f(bodies.r[body], bodies.g[body], bodies.b[body]);
+    drawSphere(bodies.radius[body], sphereLevel(bodies.radius[body], x, y, z));
+    glPopMatrix();
+}
+
+// Mass of a body in N-body mode
+float nbodyMass(int body) {
+    int parent = bodies.parent[body];
+    if (parent < 0) return SUN_MASS;
+    float radius = bodies.radius[body];
+    return parent == SUN ? PLANET_DENSITY * radius * radius * radius : MOON_MASS;
+}
+
+// Seeds the N-body system from where the bodies are now. Each body starts
+// on its orbit around its parent, moving with the parent; the moons of a
+// planet all shrink by the factor that fits the farthest one.
+void startNBody() {
+    nbody.clear();
+    nbody.theta = nbodyTheta;
+    std::vector<float> planetScale(bodies.size(), 1.0f);
+    for (int i = 0; i < bodies.size(); i++) {
+        int planet = bodies.parent[i];
+        if (planet <= SUN) continue;
+        float hill = bodies.distance[planet] * (1.0f - bodies.eccentricity[planet])
+            * cbrt(nbodyMass(planet) / (3.0f * SUN_MASS));
+        float apoapsis = bodies.distance[i] * (1.0f + bodies.eccentricity[i]);
+        planetScale[planet] = std::max(planetScale[planet], apoapsis / (MOON_HILL_FRACTION * hill));
+    }
+    moonDrawScale.assign(bodies.size(), 1.0f);
+    for (int i = 0; i < bodies.size(); i++) {
+        if (bodies.parent[i] > SUN) moonDrawScale[i] = planetScale[bodies.parent[i]];
+    }
+    for (int i = 0; i < bodies.size(); i++) {
+        int parent = bodies.parent[i];
+        if (parent < 0) {
+            nbody.add(0, 0, 0, 0, 0, 0, SUN_MASS);
+            continue;
+        }
+        float shrink = 1.0f / moonDrawScale[i];
+        
+        // Along the ellipse, at the vis-viva speed the parent's mass gives,
+        // slowed by as much as the softening weakens the pull
+        float vx, vy, vz;
+        bodies.orbitVelocity(i, vx, vy, vz);
+        float dx = (bodies.x[i] - bodies.x[parent]) * shrink;
+        float dy = (bodies.y[i] - bodies.y[parent]) * shrink;
+        float dz = (bodies.z[i] - bodies.z[parent]) * shrink;
+        float distance = sqrt(dx * dx + dy * dy + dz * dz);
+        float speed = sqrt(nbody.gravity * nbody.mass[parent] * (2.0f / distance - 1.0f / (bodies.distance[i] * shrink)));
+        speed *= pow(distance * distance / (distance * distance + nbody.softening * nbody.softening), 0.75f);
+        float scale = speed / sqrt(vx * vx + vy * vy + vz * vz);
+        nbody.add(nbody.x[parent] + dx, nbody.y[parent] + dy, nbody.z[parent] + dz,
+            nbody.vx[parent] + vx * scale, nbody.vy[parent] + vy * scale, nbody.vz[parent] + vz * scale, nbodyMass(i));
+    }
     
-    // Draw planet
-    glColor3f(planet.r, planet.g, planet.b);
-    glutSolidSphere(planet.radius, 20, 20);
-    
-    // Draw moons
-    for (size_t i = 0; i < planet.moons.size(); i++) {
-        const Planet& moon = planet.moons[i];
-        float moonX = cos(moon.angle) * moon.distance;
-        float moonZ = sin(moon.angle) * moon.distance;
+    particleRandom.seed(0, STREAM_PARTICLES);
+    for (int i = 0; i < nbodyParticles; i++) {
+        float distance = particleRandom.range(PARTICLE_DISC_INNER, PARTICLE_DISC_OUTER);
+        float angle = particleRandom.range(0.0f, 2 * PI);
+        float height = particleRandom.range(-0.5f, 0.5f) * PARTICLE_DISC_THICKNESS;
+        float speed = sqrt(nbody.gravity * SUN_MASS / distance);
+        nbody.add(cos(angle) * distance, height, sin(angle) * distance,
+            -sin(angle) * speed, 0, cos(angle) * speed, PARTICLE_MASS);
+    }
+    particleVertices.resize(nbodyParticles * 3);
+    nbody.start(jobs);
+}
+
+void drawParticles() {
+    int first = bodies.size();
+    for (int i = 0; i < nbodyParticles; i++) {
+        particleVertices[i * 3] = nbody.x[first + i];
+        particleVertices[i * 3 + 1] = nbody.y[first + i];
+        particleVertices[i * 3 + 2] = nbody.z[first + i];
+    }
+    glDisable(GL_LIGHTING);
+    glColor3f(0.6f, 0.55f, 0.5f);
+    glPointSize(1.0f);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, particleVertices.data());
+    glDrawArrays(GL_POINTS, 0, nbodyParticles);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glEnable(GL_LIGHTING);
+}
+
+void placeBelts() {
+    placeBelt(asteroidBelt, globalTime, jobs);
+    placeBelt(kuiperBelt, globalTime, jobs);
+}
+
+void drawBelt(const Belt& belt, float r, float g, float b) {
+    glDisable(GL_LIGHTING);
+    glColor3f(r, g, b);
+    glPointSize(1.0f);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, belt.vertices.data());
+    glDrawArrays(GL_POINTS, 0, belt.size());
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glEnable(GL_LIGHTING);
+}
+
+// Spectral colours from hot to cool, with the share of stars in each
+struct StarClass {
+    float r, g, b;
+    float share;
+};
+
+const StarClass STAR_CLASSES[] = {
+    {0.65f, 0.75f, 1.0f, 0.10f}, // Blue-white
+    {1.0f, 1.0f, 1.0f, 0.30f},   // White
+    {1.0f, 0.95f, 0.8f, 0.30f},  // Yellow
+    {1.0f, 0.8f, 0.6f, 0.20f},   // Orange
+    {1.0f, 0.6f, 0.5f, 0.10f}    // Red
+};
+const int STAR_CLASS_COUNT = sizeof(STAR_CLASSES) / sizeof(STAR_CLASSES[0]);
+
+void buildStars() {
+    starVertices.resize(starCount * 3);
+    starColors.resize(starCount * 3);
+    
+    for (int i = 0; i < starCount; i++) {
+        // Uniform direction on the sphere, at a random depth in the shell
+        float z = starRandom.range(-1.0f, 1.0f);
+        float angle = starRandom.range(0.0f, 2 * PI);
+        float ring = sqrt(1.0f - z * z);
+        float distance = starRandom.range(STAR_SHELL_INNER, STAR_SHELL_OUTER);
+        starVertices[i * 3] = ring * cos(angle) * distance;
+        starVertices[i * 3 + 1] = ring * sin(angle) * distance;
+        starVertices[i * 3 + 2] = z * distance;
         
-        glPushMatrix();
-        glTranslatef(moonX, 0, moonZ);
-        glColor3f(moon.r, moon.g, moon.b);
-        glutSolidSphere(moon.radius, 10, 10);
-        glPopMatrix();
+        // Faint stars far outnumber bright ones. Each magnitude is about
+        // 2.5x dimmer than the one before; the curve is flattened so the
+        // faintest still show on screen
+        float u = starRandom.nextFloat();
+        float magnitude = STAR_MAG_FAINTEST - (STAR_MAG_FAINTEST - STAR_MAG_BRIGHTEST) * u * u * u * u;
+        float brightness = pow(10.0f, -0.4f * (magnitude - STAR_MAG_BRIGHTEST));
+        brightness = 0.25f + 0.75f * pow(brightness, 0.25f);
         
-        // Draw moon orbit
-        if (showOrbits) {
-            drawOrbit(moon.distance);
+        float pick = starRandom.nextFloat();
+        int type = 0;
+        while (type < STAR_CLASS_COUNT - 1 && pick >= STAR_CLASSES[type].share) {
+            pick -= STAR_CLASSES[type].share;
+            type++;
         }
+        starColors[i * 3] = STAR_CLASSES[type].r * brightness;
+        starColors[i * 3 + 1] = STAR_CLASSES[type].g * brightness;
+        starColors[i * 3 + 2] = STAR_CLASSES[type].b * brightness;
     }
     
-    glPopMatrix();
+    // The list captures the array contents, so the field is static from here
+    if (starList == 0) starList = glGenLists(1);
+    glNewList(starList, GL_COMPILE);
+    glPointSize(1.0f);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, starVertices.data());
+    glColorPointer(3, GL_FLOAT, 0, starColors.data());
+    glDrawArrays(GL_POINTS, 0, starCount);
+    glDisableClientState(GL_COLOR_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glEndList();
 }
 
 void drawStars() {
     glDisable(GL_LIGHTING);
+    glCallList(starList);
+    glEnable(GL_LIGHTING);
+}
+
+// Radius in pixels that a sphere at world position (x, y, z) covers
+float projectedRadius(float radius, float x, float y, float z) {
+    float depth = -(viewMatrix[2] * x + viewMatrix[6] * y + viewMatrix[10] * z + viewMatrix[14]);
+    if (depth < 0.1f) return 1e6f; // At or behind the camera: draw the finest level
+    return radius * projectionScale / depth;
+}
+
+int sphereLevel(float radius, float x, float y, float z) {
+    return sphereLevelForPixels(projectedRadius(radius, x, y, z));
+}
+
+void initHud() {
+    const char* lines[] = {
+        "Controls: WASD/Arrow Keys - Rotate | Mouse - Rotate | Scroll - Zoom",
+        "Space - Pause | O - Toggle Orbits | B - Toggle Belts | +/- - Speed | [/] - Seek | 1-8 - Select Planet | G - N-Body Gravity"
+    };
+    for (int i = 0; i < NUM_HUD_LABELS; i++) {
+        initLabel(hudLabels[i], GLUT_BITMAP_HELVETICA_12, 10, WINDOW_HEIGHT - 60 - 20 * i, 1.0f, 1.0f, 1.0f);
+    }
+    
+    hudList = glGenLists(1);
+    glNewList(hudList, GL_COMPILE);
     glColor3f(1.0f, 1.0f, 1.0f);
-    glPointSize(1.0f);
+    for (int i = 0; i < (int)(sizeof(lines) / sizeof(lines[0])); i++) {
+        glRasterPos2f(10, WINDOW_HEIGHT - 20 - 20 * i);
+        emitBitmapString(GLUT_BITMAP_HELVETICA_12, lines[i]);
+    }
+    for (int i = 0; i < NUM_HUD_LABELS; i++) {
+        drawLabel(hudLabels[i]); // Recorded as calls, so label changes show through
+    }
+    glEndList();
+}
+
+// Refreshes the labels whose values have changed; formats into stack
+// buffers, so nothing is allocated
+void updateHud() {
+    int year = (int)floor(globalTime / EARTH_YEAR);
+    if (timeSpeed != shownSpeed || year != shownYear || isPaused != shownPaused) {
+        char text[MAX_LABEL_LENGTH];
+        snprintf(text, sizeof(text), "Speed: %.2fx | Year %d%s", timeSpeed, year, isPaused ? " (PAUSED)" : "");
+        setLabelText(hudLabels[HUD_STATUS], text);
+        shownSpeed = timeSpeed;
+        shownYear = year;
+        shownPaused = isPaused;
+    }
     
-    glBegin(GL_POINTS);
-    for (int i = 0; i < 500; i++) {
-        float x = (rand() % 2000 - 1000) / 10.0f;
-        float y = (rand() % 2000 - 1000) / 10.0f;
-        float z = (rand() % 2000 - 1000) / 10.0f;
-        if (sqrt(x*x + y*y + z*z) > 70.0f) {
-            glVertex3f(x, y, z);
+    if (selectedPlanet != shownSelected) {
+        char text[MAX_LABEL_LENGTH] = "";
+        if (selectedPlanet >= 0) {
+            snprintf(text, sizeof(text), "Selected: %s", bodies.nameOf(planetIds[selectedPlanet]));
         }
+        setLabelText(hudLabels[HUD_SELECTED], text);
+        shownSelected = selectedPlanet;
     }
-    glEnd();
     
-    glEnable(GL_LIGHTING);
+    // The drift moves every step, so this one is compared as text
+    char text[MAX_LABEL_LENGTH] = "";
+    if (nbodyMode) {
+        snprintf(text, sizeof(text), "N-Body: %d bodies | theta %.2f | energy drift %+.2e",
+            nbody.size(), nbody.theta, nbody.energyDrift());
+    }
+    setLabelText(hudLabels[HUD_NBODY], text);
 }
 
-void drawText(float x, float y, const std::string& text) {
+// Draws the whole HUD with one projection change and one list call
+void drawHud() {
     glDisable(GL_LIGHTING);
     glDisable(GL_DEPTH_TEST);
     
@@ -217,12 +545,7 @@ void drawText(float x, float y, const std::string& text) {
     glPushMatrix();
     glLoadIdentity();
     
-    glColor3f(1.0f, 1.0f, 1.0f);
-    glRasterPos2f(x, y);
-    
-    for (char c : text) {
-        glutBitmapCharacter(GLUT_BITMAP_HELVETICA_12, c);
-    }
+    glCallList(hudList);
     
     glPopMatrix();
     glMatrixMode(GL_PROJECTION);
@@ -233,7 +556,33 @@ void drawText(float x, float y, const std::string& text) {
     glEnable(GL_LIGHTING);
 }
 
+// Tests every body and orbit ring against the frustum in two flat passes
+void cullScene() {
+    int n = bodies.size();
+    orbitX.resize(n);
+    orbitY.resize(n);
+    orbitZ.resize(n);
+    orbitReach.resize(n);
+    bodyVisible.resize(n);
+    orbitVisible.resize(n);
+    
+    orbitX[SUN] = orbitY[SUN] = orbitZ[SUN] = orbitReach[SUN] = 0.0f;
+    for (int i = SUN + 1; i < n; i++) {
+        int parent = bodies.parent[i];
+        float shift = bodies.distance[i] * bodies.eccentricity[i];
+        orbitX[i] = bodies.x[parent] - shift * bodies.px[i];
+        orbitY[i] = bodies.y[parent] - shift * bodies.py[i];
+        orbitZ[i] = bodies.z[parent] - shift * bodies.pz[i];
+        orbitReach[i] = bodies.distance[i];
+    }
+    
+    extractFrustum(frustum, projectionMatrix, viewMatrix);
+    cullSpheres(frustum, bodies.x.data(), bodies.y.data(), bodies.z.data(), bodies.radius.data(), n, bodyVisible.data());
+    cullSpheres(frustum, orbitX.data(), orbitY.data(), orbitZ.data(), orbitReach.data(), n, orbitVisible.data());
+}
+
 void display() {
+    frameStarted();
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     
     glMatrixMode(GL_MODELVIEW);
@@ -243,59 +592,48 @@ void display() {
     glTranslatef(0, 0, -cameraDistance);
     glRotatef(cameraAngleX, 1, 0, 0);
     glRotatef(cameraAngleY, 0, 1, 0);
+    glGetFloatv(GL_MODELVIEW_MATRIX, viewMatrix);
+    cullScene();
     
     // Draw stars
     drawStars();
     
     // Draw sun
-    glPushMatrix();
-    glColor3f(sun.r, sun.g, sun.b);
-    glutSolidSphere(sun.radius, 30, 30);
-    glPopMatrix();
+    if (bodyVisible[SUN]) drawBody(SUN);
     
-    // Draw planets
-    for (size_t i = 0; i < planets.size(); i++) {
-        Planet& planet = planets[i];
-        
-        float planetX = cos(planet.angle) * planet.distance;
-        float planetZ = sin(planet.angle) * planet.distance;
-        
-        // Highlight selected planet
-        if (selectedPlanet == (int)i) {
-            glDisable(GL_LIGHTING);
-            glColor3f(1.0f, 1.0f, 0.0f);
-            glPushMatrix();
-            glTranslatef(planetX, 0, planetZ);
-            glutWireSphere(planet.radius * 1.2f, 15, 15);
-            glPopMatrix();
-            glEnable(GL_LIGHTING);
-        }
-        
-        // Draw planet orbit
-        if (showOrbits) {
-            drawOrbit(planet.distance);
+    // Draw planets and moons in view, each with its orbit around its parent
+    // (orbits are only fixed ellipses outside N-body mode)
+    for (int i = SUN + 1; i < bodies.size(); i++) {
+        if (showOrbits && !nbodyMode && orbitVisible[i]) {
+            drawOrbit(i);
         }
-        
-        // Draw planet
-        drawPlanet(planet, planetX, 0, planetZ);
+        if (bodyVisible[i]) drawBody(i);
     }
     
-    // Draw UI
-    std::string info = "Controls: WASD/Arrow Keys - Rotate | Mouse - Rotate | Scroll - Zoom";
-    drawText(10, WINDOW_HEIGHT - 20, info);
-    
-    std::string controls = "Space - Pause | O - Toggle Orbits | +/- - Speed | 1-8 - Select Planet";
-    drawText(10, WINDOW_HEIGHT - 40, controls);
-    
-    std::string status = "Speed: " + std::to_string(timeSpeed) + "x";
-    if (isPaused) status += " (PAUSED)";
-    drawText(10, WINDOW_HEIGHT - 60, status);
+    if (nbodyMode) drawParticles();
+    if (showBelts) {
+        drawBelt(asteroidBelt, 0.55f, 0.5f, 0.45f);
+        drawBelt(kuiperBelt, 0.45f, 0.55f, 0.65f);
+    }
     
-    if (selectedPlanet >= 0 && selectedPlanet < (int)planets.size()) {
-        std::string planetInfo = "Selected: " + planets[selectedPlanet].name;
-        drawText(10, WINDOW_HEIGHT - 80, planetInfo);
+    // Highlight selected planet
+    if (selectedPlanet >= 0 && bodyVisible[planetIds[selectedPlanet]]) {
+        int body = planetIds[selectedPlanet];
+        float x = bodies.x[body], y = bodies.y[body], z = bodies.z[body];
+        float radius = bodies.radius[body] * 1.2f;
+        glDisable(GL_LIGHTING);
+        glColor3f(1.0f, 1.0f, 0.0f);
+        glPushMatrix();
+        glTranslatef(x, y, z);
+        drawSphere(radius, sphereLevel(radius, x, y, z), true);
+        glPopMatrix();
+        glEnable(GL_LIGHTING);
     }
     
+    // Draw UI
+    updateHud();
+    drawHud();
+    
     glutSwapBuffers();
 }
 
@@ -303,8 +641,11 @@ void reshape(int width, int height) {
     glViewport(0, 0, width, height);
     glMatrixMode(GL_PROJECTION);
     glLoadIdentity();
-    gluPerspective(45.0, (double)width / (double)height, 0.1, 1000.0);
+    gluPerspective(FIELD_OF_VIEW, (double)width / (double)height, 0.1, 1000.0);
+    glGetFloatv(GL_PROJECTION_MATRIX, projectionMatrix);
+    projectionScale = 0.5f * height / tan(FIELD_OF_VIEW * 0.5f * PI / 180.0f);
     glMatrixMode(GL_MODELVIEW);
+    requestRedraw();
 }
 
 void keyboard(unsigned char key, int x, int y) {
@@ -314,11 +655,20 @@ void keyboard(unsigned char key, int x, int y) {
             break;
         case ' ':
             isPaused = !isPaused;
+            if (!isPaused && !clockRunning) {
+                clockRunning = true;
+                glutTimerFunc(16, update, 0);
+            }
             break;
         case 'o':
         case 'O':
             showOrbits = !showOrbits;
             break;
+        case 'b':
+        case 'B':
+            showBelts = !showBelts;
+            if (showBelts) placeBelts();
+            break;
         case '+':
         case '=':
             timeSpeed *= 1.2f;
@@ -345,13 +695,34 @@ void keyboard(unsigned char key, int x, int y) {
         case '1': case '2': case '3': case '4':
         case '5': case '6': case '7': case '8':
             selectedPlanet = key - '1';
-            if (selectedPlanet >= (int)planets.size()) selectedPlanet = -1;
+            if (selectedPlanet >= (int)planetIds.size()) selectedPlanet = -1;
             break;
         case '0':
             selectedPlanet = -1;
             break;
+        case 'g':
+        case 'G':
+            nbodyMode = !nbodyMode;
+            if (nbodyMode) {
+                startNBody();
+            } else {
+                bodies.updatePositions(globalTime); // Back onto the ellipses
+            }
+            break;
+        case '[':
+        case ']':
+            // Positions are a function of time, so a seek is one evaluation
+            // (gravity has to be integrated, so N-body mode can't seek)
+            if (!nbodyMode) {
+                globalTime += (key == ']' ? SEEK_YEARS : -SEEK_YEARS) * EARTH_YEAR;
+                bodies.updatePositions(globalTime);
+            }
+            if (showBelts) placeBelts();
+            break;
+        default:
+            return; // Nothing changed
     }
-    glutPostRedisplay();
+    requestRedraw();
 }
 
 void specialKeys(int key, int x, int y) {
@@ -368,8 +739,10 @@ void specialKeys(int key, int x, int y) {
         case GLUT_KEY_RIGHT:
             cameraAngleY += 5;
             break;
+        default:
+            return;
     }
-    glutPostRedisplay();
+    requestRedraw();
 }
 
 void mouse(int button, int state, int x, int y) {
@@ -384,11 +757,11 @@ void mouse(int button, int state, int x, int y) {
     } else if (button == 3) { // Mouse wheel up
         cameraDistance -= 2.0f;
         if (cameraDistance < 10.0f) cameraDistance = 10.0f;
-        glutPostRedisplay();
+        requestRedraw();
     } else if (button == 4) { // Mouse wheel down
         cameraDistance += 2.0f;
         if (cameraDistance > 200.0f) cameraDistance = 200.0f;
-        glutPostRedisplay();
+        requestRedraw();
     }
 }
 
@@ -398,33 +771,67 @@ void mouseMotion(int x, int y) {
         cameraAngleX += (y - lastMouseY) * 0.5f;
         lastMouseX = x;
         lastMouseY = y;
-        glutPostRedisplay();
+        requestRedraw();
     }
 }
 
+// Advances the simulation one tick. While paused the clock stops instead of
+// ticking over an unchanged scene; unpausing starts it again.
 void update(int value) {
-    if (!isPaused) {
-        globalTime += 0.016f * timeSpeed; // ~60 FPS
-        
-        // Update planet positions
-        for (Planet& planet : planets) {
-            planet.angle += planet.speed * 0.01f * timeSpeed;
-            if (planet.angle > 2 * PI) planet.angle -= 2 * PI;
-            
-            // Update moons
-            for (Planet& moon : planet.moons) {
-                moon.angle += moon.speed * 0.01f * timeSpeed;
-                if (moon.angle > 2 * PI) moon.angle -= 2 * PI;
+    if (isPaused) {
+        clockRunning = false;
+        return;
+    }
+    globalTime += TIME_STEP * timeSpeed;
+    
+    if (nbodyMode) {
+        int steps = std::max(1, (int)ceil(timeSpeed));
+        for (int step = 0; step < steps; step++) {
+            nbody.step((float)(TIME_STEP * timeSpeed / steps), jobs);
+        }
+        // Parents come before their moons, so each parent is already placed
+        for (int i = 0; i < bodies.size(); i++) {
+            int parent = bodies.parent[i];
+            if (parent <= SUN) {
+                bodies.x[i] = nbody.x[i];
+                bodies.y[i] = nbody.y[i];
+                bodies.z[i] = nbody.z[i];
+                continue;
             }
+            bodies.x[i] = bodies.x[parent] + (nbody.x[i] - nbody.x[parent]) * moonDrawScale[i];
+            bodies.y[i] = bodies.y[parent] + (nbody.y[i] - nbody.y[parent]) * moonDrawScale[i];
+            bodies.z[i] = bodies.z[parent] + (nbody.z[i] - nbody.z[parent]) * moonDrawScale[i];
         }
+    } else {
+        // Every body evaluated from its elements at the current time
+        bodies.updatePositions(globalTime);
     }
+    if (showBelts) placeBelts();
     
-    glutPostRedisplay();
+    requestRedraw();
     glutTimerFunc(16, update, 0); // ~60 FPS
 }
 
 int main(int argc, char** argv) {
     glutInit(&argc, argv);
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(argv[i]) == "--stars") {
+            starCount = atoi(argv[i + 1]);
+            if (starCount < 0) starCount = 0;
+        } else if (std::string(argv[i]) == "--nbody-particles") {
+            nbodyParticles = atoi(argv[i + 1]);
+            if (nbodyParticles < 0) nbodyParticles = 0;
+        } else if (std::string(argv[i]) == "--asteroids") {
+            asteroidCount = atoi(argv[i + 1]);
+        } else if (std::string(argv[i]) == "--kuiper") {
+            kuiperCount = atoi(argv[i + 1]);
+        } else if (std::string(argv[i]) == "--max-fps") {
+            setFrameCap(atoi(argv[i + 1]));
+        } else if (std::string(argv[i]) == "--theta") {
+            nbodyTheta = (float)atof(argv[i + 1]);
+            if (nbodyTheta < 0.0f) nbodyTheta = 0.0f;
+        }
+    }
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
     glutInitWindowSize(WINDOW_WIDTH, WINDOW_HEIGHT);
     glutCreateWindow("Interactive Solar System Simulation");
@@ -437,6 +844,7 @@ int main(int argc, char** argv) {
     glutSpecialFunc(specialKeys);
     glutMouseFunc(mouse);
     glutMotionFunc(mouseMotion);
+    clockRunning = true;
     glutTimerFunc(0, update, 0);
     
     std::cout << "Solar System Simulation Controls:" << std::endl;
@@ -448,6 +856,9 @@ int main(int argc, char** argv) {
     std::cout << "+/- - Increase/Decrease speed" << std::endl;
     std::cout << "1-8 - Select planet" << std::endl;
     std::cout << "0 - Deselect planet" << std::endl;
+    std::cout << "[ / ] - Seek back/forward " << SEEK_YEARS << " years" << std::endl;
+    std::cout << "B - Toggle asteroid and Kuiper belts" << std::endl;
+    std::cout << "G - Toggle N-body gravity" << std::endl;
     std::cout << "ESC - Exit" << std::endl;
     
     glutMainLoop();
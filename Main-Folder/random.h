@@ -0,0 +1,73 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+// Stream ids for the subsystems that draw random numbers. Generators with the
+// same seed but different streams produce independent sequences, so adding
+// draws in one subsystem never shifts another's.
+enum RandomStream {
+    STREAM_SWARM = 1,  // Mosquito placement and velocities
+    STREAM_SPRAY,      // Spray positions
+    STREAM_STARS,      // Starfield
+    STREAM_DROPLETS,   // Spray droplet directions and lifetimes
+    STREAM_BROOD,      // Egg hatch times
+    STREAM_EPIDEMIC,   // Bites and which mosquitoes start out infectious
+    STREAM_PARTICLES,  // Test particles of the N-body disc
+    STREAM_BELTS,      // Asteroid and Kuiper belt orbits
+    STREAM_WORKER = 64 // First of the per-thread streams (add the thread index)
+};
+
+// PCG32 (XSH RR) generator: 64-bit state, 32-bit output.
+// Small enough to keep one per thread or subsystem; not thread safe itself.
+struct Random {
+    uint64_t state;
+    uint64_t inc; // Stream selector; always odd
+
+    explicit Random(uint64_t seedValue = 0x853c49e6748fea9bULL, uint64_t stream = 0) {
+        seed(seedValue, stream);
+    }
+
+    // Restarts the generator at a seed on a given stream
+    void seed(uint64_t seedValue, uint64_t stream = 0) {
+        state = 0;
+        inc = (stream << 1) | 1u;
+        next();
+        state += seedValue;
+        next();
+    }
+
+    // Next 32 random bits
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + inc;
+        uint32_t xorShifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+        uint32_t rot = (uint32_t)(old >> 59);
+        return (xorShifted >> rot) | (xorShifted << ((-rot) & 31));
+    }
+
+    // Uniform float in [0, 1)
+    float nextFloat() {
+        return (next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Uniform float in [lo, hi)
+    float range(float lo, float hi) {
+        return lo + (hi - lo) * nextFloat();
+    }
+
+    // Uniform integer in [0, n)
+    int below(int n) {
+        return (int)(((uint64_t)next() * (uint32_t)n) >> 32);
+    }
+
+    // Fills out[0..count) with uniform floats in [lo, hi)
+    void fillRange(float* out, int count, float lo, float hi) {
+        float scale = (hi - lo) * (1.0f / 16777216.0f);
+        for (int i = 0; i < count; i++) {
+            out[i] = lo + (next() >> 8) * scale;
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef REDRAW_H
+#define REDRAW_H
+
+#include <GL/glut.h>
+
+// Redraws on demand. Whatever changes what is on screen (input, a
+// simulation step, an animation) calls requestRedraw(); nothing is drawn
+// otherwise, so a still window leaves GLUT asleep in its event loop.
+// An optional frame cap keeps redraws at least 1000 / maxFps ms apart:
+// a request that comes early is held back with a one-shot timer, not
+// dropped, so the last change always reaches the screen.
+struct RedrawScheduler {
+    int maxFps;      // 0 for no cap
+    int lastFrameMs; // GLUT_ELAPSED_TIME when the last frame started
+    bool pending;    // A redraw was requested and hasn't been drawn yet
+    bool deferred;   // A timer is holding the pending redraw back
+};
+
+// Function to get the program's scheduler
+inline RedrawScheduler& redrawScheduler() {
+    static RedrawScheduler scheduler = { 0, -1000000, false, false };
+    return scheduler;
+}
+
+// Function to cap the frame rate; 0 or less removes the cap
+inline void setFrameCap(int maxFps) {
+    redrawScheduler().maxFps = maxFps > 0 ? maxFps : 0;
+}
+
+// Timer callback posting a redraw that was held back by the cap
+inline void postDeferredRedraw(int /*value*/) {
+    redrawScheduler().deferred = false;
+    glutPostRedisplay();
+}
+
+// Function to ask for the window to be drawn again. Any number of requests
+// before the next frame make one redraw.
+inline void requestRedraw() {
+    RedrawScheduler& scheduler = redrawScheduler();
+    if (scheduler.pending) {
+        return;
+    }
+    scheduler.pending = true;
+    int wait = 0;
+    if (scheduler.maxFps > 0) {
+        wait = scheduler.lastFrameMs + 1000 / scheduler.maxFps - glutGet(GLUT_ELAPSED_TIME);
+    }
+    if (wait > 0 && !scheduler.deferred) {
+        scheduler.deferred = true;
+        glutTimerFunc(wait, postDeferredRedraw, 0);
+    } else if (wait <= 0) {
+        glutPostRedisplay();
+    }
+}
+
+// Function to call at the start of the display callback; it also covers
+// redraws the window system asks for itself, such as after an expose
+inline void frameStarted() {
+    RedrawScheduler& scheduler = redrawScheduler();
+    scheduler.pending = false;
+    scheduler.lastFrameMs = glutGet(GLUT_ELAPSED_TIME);
+}
+
+#endif
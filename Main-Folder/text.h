@@ -0,0 +1,69 @@
+#ifndef TEXT_H
+#define TEXT_H
+
+#include <GL/glut.h>
+#include <cstring>
+
+// Longest string a cached label can hold, including the terminator
+const int MAX_LABEL_LENGTH = 128;
+
+// A string recorded into a display list and replayed until its text changes.
+// Another display list may call the label's list; it picks up new text
+// without being re-recorded itself.
+struct TextLabel {
+    GLuint list;
+    void* font;
+    float x, y;    // Raster position in the current projection
+    float r, g, b; // Text colour
+    char text[MAX_LABEL_LENGTH];
+};
+
+// Function to emit a string at the current raster position
+inline void emitBitmapString(void* font, const char* text) {
+    for (const char* c = text; *c != '\0'; c++) {
+        glutBitmapCharacter(font, *c);
+    }
+}
+
+// Function to re-record a label's display list from its current text
+inline void compileLabel(const TextLabel& label) {
+    glNewList(label.list, GL_COMPILE);
+    glColor3f(label.r, label.g, label.b);
+    glRasterPos2f(label.x, label.y);
+    emitBitmapString(label.font, label.text);
+    glEndList();
+}
+
+// Function to set up a label; needs a current GL context
+inline void initLabel(TextLabel& label, void* font, float x, float y,
+    float r, float g, float b, const char* text = "") {
+    label.list = glGenLists(1);
+    label.font = font;
+    label.x = x;
+    label.y = y;
+    label.r = r;
+    label.g = g;
+    label.b = b;
+    strncpy(label.text, text, MAX_LABEL_LENGTH - 1);
+    label.text[MAX_LABEL_LENGTH - 1] = '\0';
+    compileLabel(label);
+}
+
+// Function to change a label's text; only re-records when the text differs.
+// Returns true when the label was rebuilt.
+inline bool setLabelText(TextLabel& label, const char* text) {
+    if (strncmp(label.text, text, MAX_LABEL_LENGTH - 1) == 0) {
+        return false;
+    }
+    strncpy(label.text, text, MAX_LABEL_LENGTH - 1);
+    label.text[MAX_LABEL_LENGTH - 1] = '\0';
+    compileLabel(label);
+    return true;
+}
+
+// Function to draw a label from its cached display list
+inline void drawLabel(const TextLabel& label) {
+    glCallList(label.list);
+}
+
+#endif